@@ -0,0 +1,148 @@
+/**
+ * \file 10-numeric-conversion.cpp
+ * \author Adam Marshall (ih8celery)
+ * \brief compare to_integer/to_float with the old verification state machine
+ */
+
+#include "convert.h"
+#include <chrono>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+  enum class DT_STATE {
+    START, LDIGIT, RDIGIT, DOT, END
+  };
+
+  // the digit-only state machine that verify_arg_type used before convert.h
+  bool legacy_verify(const std::string& arg, bool is_float) {
+    DT_STATE state = DT_STATE::START;
+
+    if (arg.empty()) {
+      return false;
+    }
+
+    for (auto i = std::begin(arg); i != std::end(arg); ++i) {
+      switch (state) {
+        case DT_STATE::START:
+          if (i + 1 == std::end(arg) && !isdigit(*i)) {
+            return false;
+          }
+          else if (isdigit(*i)) {
+            state = DT_STATE::LDIGIT;
+          }
+          else if (!isspace(*i)) {
+            return false;
+          }
+
+          break;
+        case DT_STATE::LDIGIT:
+          if (isspace(*i)) {
+            state = DT_STATE::END;
+          }
+          else if (is_float && *i == '.') {
+            state = DT_STATE::DOT;
+          }
+          else if (!isdigit(*i)) {
+            return false;
+          }
+
+          break;
+        case DT_STATE::DOT:
+          if (isdigit(*i)) {
+            state = DT_STATE::RDIGIT;
+          }
+          else {
+            return false;
+          }
+
+          break;
+        case DT_STATE::RDIGIT:
+          if (isspace(*i)) {
+            state = DT_STATE::END;
+          }
+          else if (!isdigit(*i)) {
+            return false;
+          }
+
+          break;
+        case DT_STATE::END:
+          if (!isspace(*i)) {
+            return false;
+          }
+
+          break;
+      }
+    }
+
+    return true;
+  }
+
+  template<typename Fn>
+  double time_per_arg(const std::vector<std::string>& args, Fn fn) {
+    constexpr int ROUNDS = 20;
+    double best = 1e30;
+
+    for (int r = 0; r < ROUNDS; ++r) {
+      auto start = std::chrono::steady_clock::now();
+
+      for (const std::string& arg : args) {
+        fn(arg);
+      }
+
+      auto stop = std::chrono::steady_clock::now();
+      double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+
+      if (ns < best) {
+        best = ns;
+      }
+    }
+
+    return best / args.size();
+  }
+}
+
+int main(int argc, char ** argv) {
+  std::size_t count = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 100000;
+  std::mt19937_64 gen(42);
+  std::vector<std::string> integers, floats;
+  volatile long long sink = 0;
+
+  for (std::size_t i = 0; i < count; ++i) {
+    integers.push_back(std::to_string(gen() % 1000000000));
+    floats.push_back(std::to_string(gen() % 100000) + "." + std::to_string(gen() % 100000));
+  }
+
+  double legacy_i = time_per_arg(integers, [&](const std::string& s) {
+    sink += legacy_verify(s, false);
+  });
+  double legacy_conv_i = time_per_arg(integers, [&](const std::string& s) {
+    if (legacy_verify(s, false)) sink += std::stoll(s);
+  });
+  double fused_i = time_per_arg(integers, [&](const std::string& s) {
+    std::int64_t v;
+    if (cli::to_integer(s, v) == cli::Conversion::OK) sink += v;
+  });
+
+  double legacy_f = time_per_arg(floats, [&](const std::string& s) {
+    sink += legacy_verify(s, true);
+  });
+  double legacy_conv_f = time_per_arg(floats, [&](const std::string& s) {
+    if (legacy_verify(s, true)) sink += static_cast<long long>(std::stod(s));
+  });
+  double fused_f = time_per_arg(floats, [&](const std::string& s) {
+    double v;
+    if (cli::to_float(s, v) == cli::Conversion::OK) sink += static_cast<long long>(v);
+  });
+
+  std::printf("# %zu arguments per round, best of 20 rounds, ns/arg\n", count);
+  std::printf("%-10s %16s %22s %16s\n", "type", "legacy verify", "legacy verify+stoX", "to_integer/float");
+  std::printf("%-10s %16.2f %22.2f %16.2f\n", "integer", legacy_i, legacy_conv_i, fused_i);
+  std::printf("%-10s %16.2f %22.2f %16.2f\n", "float", legacy_f, legacy_conv_f, fused_f);
+
+  return 0;
+}
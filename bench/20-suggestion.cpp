@@ -0,0 +1,92 @@
+/**
+ * \file 20-suggestion.cpp
+ * \author Adam Marshall (ih8celery)
+ * \brief latency of Command::suggest against a linear scan of handles
+ */
+
+#include "cmdparse.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+  const char * WORDS[] = {
+    "verbose", "output", "input", "format", "color", "depth", "threads",
+    "cache", "config", "debug", "level", "prefix", "suffix", "timeout",
+    "retry", "limit", "mode", "user", "group", "path"
+  };
+
+  std::string random_handle(std::mt19937& gen) {
+    std::string handle("--");
+
+    handle += WORDS[gen() % 20];
+    handle += "-";
+    handle += WORDS[gen() % 20];
+    handle += "-";
+    handle += std::to_string(gen() % 1000);
+
+    return handle;
+  }
+
+  std::string typo(std::string handle, std::mt19937& gen) {
+    std::size_t at = 2 + gen() % (handle.size() - 2);
+
+    handle[at] = 'a' + gen() % 26;
+
+    return handle;
+  }
+}
+
+int main(int argc, char ** argv) {
+  std::size_t count = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 10000;
+  constexpr int QUERIES = 1000;
+  std::mt19937 gen(7);
+  std::vector<std::string> handles, queries;
+  cli::Command cmd;
+
+  while (handles.size() < count) {
+    std::string handle = random_handle(gen);
+
+    try {
+      cmd.option(handle);
+      handles.push_back(handle);
+    }
+    catch (cli::option_language_error&) {
+      // duplicate handle; draw again
+    }
+  }
+
+  for (int i = 0; i < QUERIES; ++i) {
+    queries.push_back(typo(handles[gen() % handles.size()], gen));
+  }
+
+  std::size_t found = 0;
+  auto start = std::chrono::steady_clock::now();
+
+  for (const std::string& query : queries) {
+    found += cmd.suggest(query).size();
+  }
+
+  auto middle = std::chrono::steady_clock::now();
+
+  for (const std::string& query : queries) {
+    for (const std::string& handle : handles) {
+      found += (cli::edit_distance(query, handle) <= 3);
+    }
+  }
+
+  auto stop = std::chrono::steady_clock::now();
+
+  double indexed = std::chrono::duration<double, std::micro>(middle - start).count() / QUERIES;
+  double linear  = std::chrono::duration<double, std::micro>(stop - middle).count() / QUERIES;
+
+  std::printf("# %zu handles, %d mistyped queries (%zu matches)\n", count, QUERIES, found);
+  std::printf("%-16s %12s\n", "method", "us/query");
+  std::printf("%-16s %12.2f\n", "BK_Tree", indexed);
+  std::printf("%-16s %12.2f\n", "linear scan", linear);
+
+  return 0;
+}
@@ -0,0 +1,83 @@
+/**
+ * \file 30-completion.cpp
+ * \author Adam Marshall (ih8celery)
+ * \brief latency of Command::complete over a deep tree of commands
+ */
+
+#include "cmdparse.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+int main(int argc, char ** argv) {
+  int handles         = (argc > 1) ? std::atoi(argv[1]) : 5000;
+  constexpr int DEPTH = 8;
+  constexpr int WIDTH = 10;
+  constexpr int QUERIES = 10000;
+  cli::Command root;
+  std::vector<std::shared_ptr<cli::Command>> level{ nullptr };
+  std::shared_ptr<cli::Command> leaf;
+  std::vector<std::string> words;
+
+  // a chain of commands, each with WIDTH siblings, sharing the handles out
+  for (int depth = 0; depth < DEPTH; ++depth) {
+    cli::Command& parent = (depth == 0) ? root : *leaf;
+
+    for (int sibling = WIDTH - 1; sibling >= 0; --sibling) {
+      auto cmd = parent.command("cmd" + std::to_string(depth) + "-" + std::to_string(sibling));
+
+      if (sibling == 0) {
+        leaf = cmd;
+        words.push_back("cmd" + std::to_string(depth) + "-0");
+      }
+    }
+  }
+
+  for (int i = 0; i < handles; ++i) {
+    std::string spec = "--opt-" + std::to_string(i) + "=s{alpha,beta,gamma}";
+
+    if (i % 2 == 0) {
+      root.option(spec);
+    }
+    else {
+      leaf->option(spec);
+    }
+  }
+
+  std::vector<const char *> line;
+  for (const std::string& word : words) {
+    line.push_back(word.c_str());
+  }
+
+  const char * partials[] = { "--opt-1", "--opt-42", "--opt-4999=b", "", "--" };
+  std::size_t found = 0;
+  double worst      = 0;
+
+  for (const char * partial : partials) {
+    line.push_back(partial);
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < QUERIES; ++i) {
+      found += root.complete(line.data(), line.size(), line.size() - 1).size();
+    }
+
+    auto stop = std::chrono::steady_clock::now();
+    double us = std::chrono::duration<double, std::micro>(stop - start).count() / QUERIES;
+
+    std::printf("%-14s %10.2f us/query\n", (std::string("'") + partial + "'").c_str(), us);
+
+    if (us > worst) {
+      worst = us;
+    }
+
+    line.pop_back();
+  }
+
+  std::printf("# %d handles, %d levels of %d commands, worst %.2f us (%zu matches)\n",
+      handles, DEPTH, WIDTH, worst, found);
+
+  return 0;
+}
@@ -0,0 +1,42 @@
+/**
+ * \file 40-list.cpp
+ * \author Adam Marshall (ih8celery)
+ * \brief time to parse one integer list option with many elements
+ */
+
+#include "cmdparse.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+int main(int argc, char ** argv) {
+  int elements         = (argc > 1) ? std::atoi(argv[1]) : 1000000;
+  constexpr int ROUNDS = 10;
+  cli::Command cmd;
+  std::string list = "--ids=";
+  std::size_t kept = 0;
+
+  cmd.option("--ids=[i{0..}]", "ids");
+
+  for (int i = 0; i < elements; ++i) {
+    list += std::to_string(i * 7919L % 1000003L);
+    list += ',';
+  }
+
+  auto start = std::chrono::steady_clock::now();
+
+  for (int i = 0; i < ROUNDS; ++i) {
+    char * args[] = { &list[0] };
+
+    kept += cmd.parse(args, 1).count("ids");
+  }
+
+  auto stop = std::chrono::steady_clock::now();
+  double ms = std::chrono::duration<double, std::milli>(stop - start).count() / ROUNDS;
+
+  std::printf("# %d elements, %zu bytes: %.2f ms/parse (%zu kept)\n",
+      elements, list.size(), ms, kept / ROUNDS);
+
+  return 0;
+}
@@ -0,0 +1,48 @@
+/**
+ * \file 50-declare.cpp
+ * \author Adam Marshall (ih8celery)
+ * \brief time to declare many options one at a time and as one table
+ */
+
+#include "cmdparse.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+int main(int argc, char ** argv) {
+  int count            = (argc > 1) ? std::atoi(argv[1]) : 10000;
+  constexpr int ROUNDS = 5;
+  std::vector<cli::Option_Spec> specs;
+  double single = 0, bulk = 0;
+
+  for (int i = 0; i < count; ++i) {
+    std::string n = std::to_string(i);
+
+    specs.push_back(cli::Option_Spec{ "--option-" + n + "|-o" + n + "=i", "" });
+  }
+
+  for (int i = 0; i < ROUNDS; ++i) {
+    cli::Command one, table;
+    auto start = std::chrono::steady_clock::now();
+
+    for (const auto& spec : specs) {
+      one.option(spec.spec, spec.name);
+    }
+
+    auto middle = std::chrono::steady_clock::now();
+
+    table.options(specs);
+
+    auto stop = std::chrono::steady_clock::now();
+
+    single += std::chrono::duration<double, std::milli>(middle - start).count();
+    bulk   += std::chrono::duration<double, std::milli>(stop - middle).count();
+  }
+
+  std::printf("# %d options: %.2f ms one at a time, %.2f ms as a table\n",
+      count, single / ROUNDS, bulk / ROUNDS);
+
+  return 0;
+}
@@ -0,0 +1,224 @@
+/**
+ * \file 60-getopt.cpp
+ * \author Adam Marshall (ih8celery)
+ * \brief cmdparse against glibc's getopt_long on the same options and words
+ *
+ * both sides declare the same options and keep what they find: getopt
+ * counts flags and pushes each value onto a vector, as a program using
+ * it would, and cmdparse keeps its Info. allocations are counted by
+ * the support library of the tests. each side runs in a process of
+ * its own, and rss is how far its resident set peaked above what it
+ * started with.
+ */
+
+#include "cmdparse.h"
+#include "budget.h"
+#include <getopt.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+  constexpr int ROUNDS = 10;
+
+  struct Result {
+    double ns;               // per word
+    std::size_t allocations; // per parse
+    long rss;                // KiB
+  };
+
+  // what a getopt program keeps
+  struct Found {
+    int verbose = 0, quiet = 0, all = 0;
+    std::vector<const char *> outputs, names;
+    std::vector<long> levels;
+  };
+
+  const option long_options[] = {
+    { "verbose", no_argument,       nullptr, 'v' },
+    { "quiet",   no_argument,       nullptr, 'q' },
+    { "all",     no_argument,       nullptr, 'a' },
+    { "output",  required_argument, nullptr, 'o' },
+    { "level",   required_argument, nullptr, 'l' },
+    { "name",    required_argument, nullptr, 'n' },
+    { nullptr,   0,                 nullptr, 0 }
+  };
+
+  void declare(cli::Command& cmd) {
+    cmd.option("-v|--verbose*", "verbose");
+    cmd.option("-q|--quiet*", "quiet");
+    cmd.option("-a|--all*", "all");
+    cmd.option("-o|--output*=?[s]", "output");
+    cmd.option("-l|--level*=?[i]", "level");
+    cmd.option("-n|--name*=?[s]", "name");
+  }
+
+  long resident_kib() {
+    long pages = 0, resident = 0;
+    std::FILE * statm = std::fopen("/proc/self/statm", "r");
+
+    if (statm != nullptr) {
+      if (std::fscanf(statm, "%ld %ld", &pages, &resident) != 2) {
+        resident = 0;
+      }
+
+      std::fclose(statm);
+    }
+
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+  }
+
+  // argv is made again before each parse, since both sides rearrange it
+  template <typename Parse>
+  Result measure(std::vector<std::string> words, Parse&& parse) {
+    std::vector<char *> argv;
+    double ns = 0;
+    Result result{ 0, 0, 0 };
+
+    for (int round = 0; round <= ROUNDS; ++round) {
+      argv.clear();
+      argv.push_back(const_cast<char *>("bench"));
+
+      for (std::string& word : words) {
+        argv.push_back(&word[0]);
+      }
+
+      budget::Region region;
+      auto start = std::chrono::steady_clock::now();
+      auto kept  = parse(argv);
+      auto stop  = std::chrono::steady_clock::now();
+
+      // the first round only warms the caches
+      if (round > 0) {
+        ns += std::chrono::duration<double, std::nano>(stop - start).count();
+        result.allocations = region.usage().allocations;
+      }
+
+      (void)kept;
+    }
+
+    result.ns = ns / ROUNDS / words.size();
+
+    return result;
+  }
+
+  // measure in a child process, whose peak resident set is its own
+  template <typename Parse>
+  Result isolated(const std::vector<std::string>& words, Parse&& parse) {
+    Result result{ 0, 0, 0 };
+    int fds[2];
+
+    if (pipe(fds) != 0) {
+      return result;
+    }
+
+    pid_t pid = fork();
+
+    if (pid == 0) {
+      long start = resident_kib();
+      rusage usage;
+
+      result = measure(words, parse);
+      getrusage(RUSAGE_SELF, &usage);
+      result.rss = usage.ru_maxrss - start;
+
+      ssize_t written = write(fds[1], &result, sizeof(result));
+      _exit(written == sizeof(result) ? 0 : 1);
+    }
+
+    if (read(fds[0], &result, sizeof(result)) != sizeof(result)) {
+      result = Result{ 0, 0, 0 };
+    }
+
+    close(fds[0]);
+    close(fds[1]);
+    waitpid(pid, nullptr, 0);
+
+    return result;
+  }
+
+  Found run_getopt(std::vector<char *>& argv) {
+    Found found;
+    int ch;
+
+    optind = 0;
+    opterr = 0;
+
+    while ((ch = getopt_long(argv.size(), argv.data(), "vqao:l:n:", long_options, nullptr)) != -1) {
+      switch (ch) {
+      case 'v': ++found.verbose; break;
+      case 'q': ++found.quiet; break;
+      case 'a': ++found.all; break;
+      case 'o': found.outputs.push_back(optarg); break;
+      case 'l': found.levels.push_back(std::strtol(optarg, nullptr, 10)); break;
+      case 'n': found.names.push_back(optarg); break;
+      default: break;
+      }
+    }
+
+    return found;
+  }
+
+  void compare(const char * workload, const std::vector<std::string>& words,
+               const cli::Command& cmd) {
+    Result getopt_result   = isolated(words, run_getopt);
+    Result cmdparse_result = isolated(words, [&](std::vector<char *>& argv) {
+      return cmd.parse(argv.data() + 1, argv.size() - 1);
+    });
+
+    std::printf("%-14s %8zu %10.1f %8zu %8ld %10.1f %8zu %8ld %6.2fx\n",
+        workload, words.size(),
+        getopt_result.ns, getopt_result.allocations, getopt_result.rss,
+        cmdparse_result.ns, cmdparse_result.allocations, cmdparse_result.rss,
+        cmdparse_result.ns / getopt_result.ns);
+  }
+}
+
+int main(int argc, char ** argv) {
+  int count = (argc > 1) ? std::atoi(argv[1]) : 1000;
+  cli::Command cmd;
+  std::vector<std::string> shorts, longs, mixed, large;
+  const char * flags[] = { "-v", "-q", "-a" };
+
+  declare(cmd);
+
+  for (int i = 0; i < count; ++i) {
+    shorts.push_back(flags[i % 3]);
+
+    switch (i % 4) {
+    case 0: longs.push_back("--verbose"); break;
+    case 1: longs.push_back("--level=" + std::to_string(i)); break;
+    case 2: longs.push_back("--name=n" + std::to_string(i)); break;
+    case 3: longs.push_back("--output=out" + std::to_string(i) + ".txt"); break;
+    }
+
+    switch (i % 4) {
+    case 0: mixed.push_back("-v"); break;
+    case 1: mixed.push_back("file" + std::to_string(i) + ".c"); break;
+    case 2: mixed.push_back("--name=n" + std::to_string(i)); break;
+    case 3: mixed.push_back("dir/" + std::to_string(i)); break;
+    }
+  }
+
+  for (int i = 0; i < 10 * count; ++i) {
+    large.push_back((i % 2) ? longs[(i / 2) % count] : mixed[(i / 2) % count]);
+  }
+
+  std::printf("# %-12s %8s %10s %8s %8s %10s %8s %8s %7s\n", "", "",
+      "getopt", "", "", "cmdparse", "", "", "");
+  std::printf("# %-12s %8s %10s %8s %8s %10s %8s %8s %7s\n", "workload", "words",
+      "ns/word", "allocs", "rss KiB", "ns/word", "allocs", "rss KiB", "ratio");
+
+  compare("short-only", shorts, cmd);
+  compare("long =", longs, cmd);
+  compare("mixed", mixed, cmd);
+  compare("large argc", large, cmd);
+
+  return 0;
+}
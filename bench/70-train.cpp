@@ -0,0 +1,81 @@
+/**
+ * \file 70-train.cpp
+ * \author Adam Marshall (ih8celery)
+ * \brief the workload a profile-guided build of the library is trained on
+ *
+ * a mix of what programs ask of the parser: flags, long options with
+ * and without '=', typed lists, subcommands, mistakes reported through
+ * Diagnostics, and lookups in the Info afterward. built and run only by
+ * the instrumented build that ENABLE_PGO starts.
+ */
+
+#include "cmdparse.h"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace {
+  // pointers to words, made again before each parse blanks them
+  std::vector<char *> argv_of(std::vector<std::string>& words) {
+    std::vector<char *> argv;
+
+    for (std::string& word : words) {
+      argv.push_back(&word[0]);
+    }
+
+    return argv;
+  }
+}
+
+int main(int argc, char ** argv) {
+  int rounds = (argc > 1) ? std::atoi(argv[1]) : 2000;
+  cli::Command cmd;
+  std::size_t found = 0;
+
+  cmd.option("-v|--verbose*", "verbose");
+  cmd.option("-q|--quiet", "quiet");
+  cmd.option("-o|--output=?s", "output");
+  cmd.option("--level=i{0..9}", "level");
+  cmd.option("--ratio=f", "ratio");
+  cmd.option("--mode=s{fast,safe}", "mode");
+  cmd.option("-I=|s", "include");
+  cmd.option("--tags*=[s]", "tags");
+  cmd.option("--ids=[i]", "ids");
+  cmd.option("--color!", "color");
+
+  auto remote = cmd.command("remote");
+  remote->option("--fetch", "fetch");
+  remote->option("--url=s", "url");
+
+  std::vector<std::vector<std::string>> lines = {
+    { "-v", "-v", "--quiet", "--output", "out.txt", "file.c", "--level=3" },
+    { "--verbose", "--ratio=0.25", "--mode=safe", "-Iinclude", "a", "b", "--", "-c" },
+    { "--tags=a,b,c", "--tags=d", "--ids=1,2,0x10,4K", "--no-color", "-o", "x" },
+    { "remote", "--fetch", "--url=https://example.com", "-v" },
+    { "--levl=3", "--mode=slow", "--ids=1,x", "--unknown", "-q", "-q" }
+  };
+
+  for (int round = 0; round < rounds; ++round) {
+    for (auto& line : lines) {
+      cli::Diagnostics diags;
+      std::vector<char *> args = argv_of(line);
+      cli::Info info           = cmd.parse(args.data(), args.size(), diags);
+
+      found += info.count("verbose") + info.has("quiet") + diags.size();
+      found += info.find("output").has_value() + info.find_integer("level").value_or(0);
+
+      if (auto ids = info.find_integers("ids")) {
+        found += ids->size();
+      }
+
+      if (auto tags = info.find_all("tags")) {
+        found += tags->size();
+      }
+    }
+  }
+
+  std::printf("# %d rounds of %zu lines: %zu found\n", rounds, lines.size(), found);
+
+  return 0;
+}
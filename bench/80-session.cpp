@@ -0,0 +1,64 @@
+/**
+ * \file 80-session.cpp
+ * \author Adam Marshall (ih8celery)
+ * \brief time to update a Session after one keystroke on a long line
+ */
+
+#include "session.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+using Clock = std::chrono::steady_clock;
+
+// microseconds per edit of typing text at offset and deleting it again
+double retype(cli::Session& session, std::size_t offset, const std::string& text, int rounds) {
+  auto start = Clock::now();
+
+  for (int i = 0; i < rounds; ++i) {
+    session.edit(offset, 0, text);
+    session.edit(offset, text.size(), "");
+  }
+
+  auto stop = Clock::now();
+
+  return std::chrono::duration<double, std::micro>(stop - start).count() / (2 * rounds);
+}
+
+int main(int argc, char ** argv) {
+  int words            = (argc > 1) ? std::atoi(argv[1]) : 200000;
+  constexpr int ROUNDS = 1000;
+  cli::Command cmd;
+  std::string line;
+
+  cmd.option("--verbose?", "verbose");
+  cmd.option("--level=i{0..9}", "level");
+  cmd.option("--out=!s", "out");
+
+  for (int i = 0; i < words / 4; ++i) {
+    line += "--verbose --level=3 --out file ";
+  }
+
+  auto start = Clock::now();
+  cli::Session session(cmd, line);
+  auto stop  = Clock::now();
+
+  std::printf("# %d words, %zu bytes: %.2f ms to start\n", words, line.size(),
+      std::chrono::duration<double, std::milli>(stop - start).count());
+
+  const char * places[] = { "front", "middle", "end" };
+  std::size_t files[]   = { line.find("file"), line.find("file", line.size() / 2),
+                            line.rfind("file") };
+
+  for (int i = 0; i < 3; ++i) {
+    std::size_t handle = line.rfind("--verbose", files[i]) + 8;
+
+    std::printf("# %-6s %.2f us/letter, %.2f us/space, %.2f us/handle\n", places[i],
+        retype(session, files[i] + 2, "x", ROUNDS),
+        retype(session, files[i] + 2, " ", ROUNDS),
+        retype(session, handle, "x", ROUNDS));
+  }
+
+  return 0;
+}
@@ -9,137 +9,99 @@
 
 #define _MOD_CPP_COMMAND_PARSE
 
+#include "option.h"
+#include "info.h"
+#include "suggest.h"
+#include "prefix.h"
+
 #include <unordered_map>
-#include <set>
+#include <unordered_set>
 #include <string>
+#include <string_view>
 #include <vector>
+#include <initializer_list>
+#include <utility>
 #include <exception>
-#include <optional>
 #include <memory>
-#include <tuple>
+#include <atomic>
+#include <ostream>
+#include <cstddef>
+#include <cstdint>
 
 namespace cli {
-  namespace Property {
-    /**
-     * \enum Number
-     * \brief defines the number of times an option may appear
-     *
-     * <number> := <nil> // Number::ZERO_ONE <br>
-     *          | '?'    // Number::ZERO_ONE <br>
-     *          | '*'    // Number::ZERO_MANY <br>
-     */
-    enum class Number {
-      ZERO_ONE, ZERO_MANY
-    };
-
-    /**
-     * \enum Assignment
-     * \brief defines the mode of assignment supported by option
-     *
-     * <assignment> := <nil> // Assignment::NONE <br>
-     *              | '='   // Assignment::EQ_REQUIRED <br>
-     *              | '=?'  // Assignment::EQ_MAYBE <br>
-     *              | '=!'  // Assignment::EQ_NEVER <br>
-     *              | '=|'  // Assignment::STUCK_ARG <br>
-     */
-    enum class Assignment {
-      NO_ASSIGN, EQ_REQUIRED, EQ_MAYBE, EQ_NEVER, STUCK
-    };
-    
-    /**
-     * \enum Collection
-     * \brief defines how arguments are interpreted
-     *
-     * <collection> := <nil>            // Collection::SCALAR <br>
-     *              | '['<data_prop>']' // Collection::LIST <br>
-     */
-    enum class Collection {
-      SCALAR, LIST
-    };
-    
-    /**
-     * \enum Arg_Type
-     * \brief defines the type of data of an option's argument
-     *
-     * <data_type> := <nil> // Arg_Type::STRING <br>
-     *             | 's'   // Arg_Type::STRING <br>
-     *             | 'i'   // Arg_Type::INTEGER <br>
-     *             | 'f'   // Arg_Type::FLOAT <br>
-     */
-    enum class Arg_Type {
-      STRING, INTEGER, FLOAT
-    };
-  }
-
   /**
-   * \struct Option
-   * \brief collect the properties and identity of option
+   * \enum Error_Code
+   * \brief identifies the kind of problem found during parsing
    */
-  class Option {
-    public:
-      Option();
-
-      Property::Number number;
-      Property::Assignment assignment;
-      Property::Collection collection;
-      Property::Arg_Type type;
-      std::string name;
-
-      friend bool operator<(const Option&, const Option&) noexcept;
-      friend bool operator==(const Option&, const Option&) noexcept;
+  enum class Error_Code : std::uint8_t {
+    NONE,
+    COMMAND_NOT_FOUND,   // named command does not match argv
+    UNKNOWN_COMMAND,     // argument does not match any subcommand
+    INVALID_PREFIX,      // malformed prefix in a bsd or merged option
+    SPECIAL_PREFIX,      // bsd option used a prefix
+    SPECIAL_MIXED,       // only some characters of a merged option are known
+    SPECIAL_ASSIGN,      // bsd or merged option given an argument
+    UNKNOWN_OPTION,      // prefixed argument does not match any handle
+    REPEATED,            // option found more often than its number allows
+    UNEXPECTED_ARGUMENT, // argument given to an option that takes none
+    MISSING_EQUALS,      // EQ_REQUIRED option used without '='
+    MISSING_ARGUMENT,    // option requires an argument that is absent
+    BAD_FORMAT,          // argument does not match its declared type
+    OUT_OF_RANGE,        // numeric argument overflows its type
+    NOT_IN_RANGE,        // numeric argument outside the declared range
+    NOT_A_CHOICE,        // string argument not among the declared choices
+    AMBIGUOUS_OPTION,    // abbreviation matches handles of several options
+    DUPLICATE_KEY,       // map option declared with '!' given a key twice
+    MISSING_REQUIRED,    // required option, or every option of a group, absent
+    MISSING_DEPENDENCY,  // option given without an option it depends on
+    CONFLICTING_OPTIONS  // options that exclude each other given together
   };
 
-  using opt_data_t = std::unordered_multimap<std::string, std::string>;
   /**
-   * \class Info
-   * \brief represent data collected during parsing
+   * \fn const char * describe(Error_Code)
+   * \brief short, static description of an error code
    */
-  class Info {
-    friend class Command;
+  const char * describe(Error_Code) noexcept;
 
-    public:
-      /**
-       * \fn bool has(const string&)
-       * \brief test whether a particular option was found in parsing
-       */
-      bool has(const std::string&) const;
-
-      /**
-       * \fn bool has_command(const string&)
-       * \brief test whether a command was found in argv
-       */
-      bool has_command(const std::string&) const;
-      
-      /**
-       * \fn optional<string> find(const string&)
-       * \brief retrieve value of option
-       */
-      std::optional<std::string> find(const std::string&) const;
-      std::optional<std::string> operator[] (const std::string&) const;
-      
-      /**
-       * \fn optional<vector<string>> find_all(const string&)
-       * \brief retrieve the vector of values under name
-       */
-      std::optional<std::vector<std::string>> find_all(const std::string&) const;
-
-      /**
-       * \fn opt_data_t::size_type count(const string&)
-       * \brief count occurrences of option during parsing
-       */
-      opt_data_t::size_type count(const std::string&) const;
+  /**
+   * \struct Diagnostic
+   * \brief one problem recorded by parse in collect mode
+   *
+   * index is the position in the argv given to the outermost parse, <br>
+   * offset is the position of the problem within that argument, and <br>
+   * option is the id of the option involved (see Command::option_name) <br>
+   * or -1 if there was none. <br>
+   */
+  struct Diagnostic {
+    Error_Code code;
+    std::uint32_t offset;
+    std::int32_t index;
+    std::int32_t option;
+  };
 
-      /**
-       * \var vector<string> rest
-       * \brief contains non-options found during parsing
-       */
-      std::vector<std::string> rest;
+  using Diagnostics = std::vector<Diagnostic>;
 
-    private:
-      opt_data_t data;
-      std::set<std::string> commands;
+  /**
+   * \struct Option_Spec
+   * \brief the two arguments of Command::option, for Command::options
+   */
+  struct Option_Spec {
+    std::string spec;
+    std::string name;
   };
 
+  /**
+   * \struct Memory_Usage
+   * \brief approximate bytes held by the option tables of a Command
+   *
+   * own counts the tables and options of the Command itself, shared <br>
+   * those of the base it was made from, which every Command made <br>
+   * from that base holds in common. <br>
+   */
+  struct Memory_Usage {
+    std::size_t own;
+    std::size_t shared;
+  };
 
   /**
    * \class opt_parser
@@ -159,6 +121,21 @@ namespace cli {
        */
       Command(const std::string&);
 
+      /**
+       * \fn Command(std::shared_ptr<const Command>, const std::string& = "")
+       * \brief create a Command that starts with the options of another
+       *
+       * the options of the base are looked up in place rather than <br>
+       * copied, so many Commands made from one base hold its tables <br>
+       * once. option() adds to this Command alone; a handle declared <br>
+       * here hides the same handle of the base, and a name known to <br>
+       * the base keeps its id. the configuration is copied from the <br>
+       * base, but not its subcommands, constraints or bindings. <br>
+       * once shared, option(), options(), configure() and clear() <br>
+       * on the base throw command_error; a clone() of it may change. <br>
+       */
+      Command(std::shared_ptr<const Command>, const std::string& = "");
+
       /**
        * \fn std::shared_ptr<Option> option(const std::string&*, const std::string&* = "")
        * \brief declare an option to the parser
@@ -169,6 +146,32 @@ namespace cli {
        */
       std::shared_ptr<Option> option(const std::string&, const std::string& = "");
 
+      /**
+       * \fn std::size_t options(std::initializer_list<Option_Spec>)
+       * \brief declare a whole table of options at once
+       *
+       * every spec is read before any is declared, so a table with <br>
+       * errors declares nothing and one option_language_error lists <br>
+       * every bad spec and repeated handle. otherwise the tables are <br>
+       * sized once for all of the options, and the sorted index of <br>
+       * handles is built in one pass. returns the number declared. <br>
+       * also takes a vector, or a pointer and a count. <br>
+       */
+      std::size_t options(std::initializer_list<Option_Spec>);
+      std::size_t options(const std::vector<Option_Spec>&);
+      std::size_t options(const Option_Spec *, std::size_t);
+
+      /**
+       * \fn std::size_t declare_registered()
+       * \brief declare every option registered by CMDPARSE_DEFINE_OPTION
+       *
+       * call once, before the first parse. the tables are sized for <br>
+       * all of the options at once, and options registered by one <br>
+       * translation unit are declared in the order they appear in it. <br>
+       * returns the number declared. see registry.h <br>
+       */
+      std::size_t declare_registered();
+
       /**
        * \fn std::shared_ptr<Command> command(const std::string&*)
        * \brief declare a command owned by this object
@@ -179,13 +182,173 @@ namespace cli {
        * \fn opt_info parse(char **&, int)
        * \brief extract options from argv into an opt_info object
        *
-       * any options or data belonging to options is removed from <br>
-       * argv and replaced with nullptr. <br>
+       * argv is left as given; the words consumed are marked in a <br>
+       * copy of the array. permute() consumes argv itself. <br>
        * throws a parse_error if something goes wrong <br>
        */
       Info parse(char **, int, Info * = nullptr) const;
       Info operator()(char**, int);
 
+      /**
+       * \fn void required(const std::string&)
+       * \brief every parse must find the option with this name
+       *
+       * this and the other constraints below name options already <br>
+       * declared with option(), or throw an option_language_error. <br>
+       * they are kept as bitmasks over option ids and checked once at <br>
+       * the end of each parse, against the options that parse found. <br>
+       * a violation is reported like any other problem, at the index <br>
+       * of the first use of the option involved, or at argc if none. <br>
+       */
+      void required(const std::string&);
+
+      /**
+       * \fn void depends(const std::string&, const std::vector<std::string>&)
+       * \brief the first option may only be given with all of the others
+       */
+      void depends(const std::string&, const std::vector<std::string>&);
+
+      /**
+       * \fn void conflicts(const std::string&, const std::vector<std::string>&)
+       * \brief the first option may not be given with any of the others
+       */
+      void conflicts(const std::string&, const std::vector<std::string>&);
+
+      /**
+       * \fn void at_least_one(const std::vector<std::string>&)
+       * \brief one or more of the options must be given
+       */
+      void at_least_one(const std::vector<std::string>&);
+
+      /**
+       * \fn void exactly_one(const std::vector<std::string>&)
+       * \brief one and only one of the options must be given
+       */
+      void exactly_one(const std::vector<std::string>&);
+
+      /**
+       * \fn Info parse(char **, int, Diagnostics&, Info * = nullptr)
+       * \brief parse without stopping at the first problem
+       *
+       * instead of throwing a parse_error, every problem found is <br>
+       * appended to the Diagnostics argument and parsing continues <br>
+       * with the next argument. Info receives whatever was valid. <br>
+       */
+      Info parse(char **, int, Diagnostics&, Info * = nullptr) const;
+
+      /**
+       * \fn Info parse(const char * const *, int, Info * = nullptr)
+       * \brief parse an argv that cannot be written
+       *
+       * like every parse, the array of pointers, not the strings, is <br>
+       * copied once. also available with Diagnostics. <br>
+       */
+      Info parse(const char * const *, int, Info * = nullptr) const;
+      Info parse(const char * const *, int, Diagnostics&, Info * = nullptr) const;
+
+      /**
+       * \fn void bind_env(const std::string&, const std::string&)
+       * \brief let an environment variable give the option a value
+       *
+       * the first argument names a declared option, or an <br>
+       * option_language_error is thrown. see parse_sources <br>
+       */
+      void bind_env(const std::string&, const std::string&);
+
+      /**
+       * \fn void bind_key(const std::string&, const std::string&)
+       * \brief let a key of a config file give the option a value
+       */
+      void bind_key(const std::string&, const std::string&);
+
+      /**
+       * \fn Info parse_sources(char **, int, const std::string&, Info * = nullptr)
+       * \brief parse argv, then the environment, then a config file
+       *
+       * argv is parsed as by parse. the environment is scanned once <br>
+       * for the variables bound by bind_env, then the file named by <br>
+       * the third argument is mapped and read for the keys bound by <br>
+       * bind_key; see doc/options.md for its format. a missing file <br>
+       * or an empty name is skipped; other failures to read the file <br>
+       * throw std::system_error. an option found in argv ignores the <br>
+       * other sources, and one found in the environment ignores the <br>
+       * file. a value is checked as the argument of its option; a <br>
+       * flag takes 1, true, yes or on to be set. constraints are <br>
+       * checked over all three sources. problems are reported with <br>
+       * index -1 and, for the file, the offset of the byte within it. <br>
+       * also available with Diagnostics. <br>
+       */
+      Info parse_sources(char **, int, const std::string&, Info * = nullptr) const;
+      Info parse_sources(char **, int, const std::string&, Diagnostics&,
+                         Info * = nullptr) const;
+
+      /**
+       * \fn int permute(char **, int, Info&)
+       * \brief parse into Info, then move what is left to the front
+       *
+       * like the permutation done by getopt: the arguments parse did <br>
+       * not consume keep their order at the front of argv and their <br>
+       * count is returned, so later stages see no empty holes. one <br>
+       * pass over argv with no allocation. also available with <br>
+       * Diagnostics. <br>
+       */
+      int permute(char **, int, Info&) const;
+      int permute(char **, int, Info&, Diagnostics&) const;
+
+      /**
+       * \fn const std::string& option_name(int) const
+       * \brief find the name of the option with an id
+       *
+       * ids are assigned per name by option(), starting from 0 <br>
+       */
+      const std::string& option_name(int) const;
+
+      /**
+       * \fn vector<string> complete(const char * const *, int, int) const
+       * \brief list the words that may complete a partial command line
+       *
+       * argv holds argc words and the third argument is the index of <br>
+       * the word being completed, which may equal argc for a new word. <br>
+       * subcommands are followed as far as argv goes; the result holds <br>
+       * the subcommand names, handles or declared choices that begin <br>
+       * with the word, sorted. <br>
+       */
+      std::vector<std::string> complete(const char * const *, int, int) const;
+
+      /**
+       * \fn bool serve_completion(int, const char * const *, std::ostream&) const
+       * \brief answer a shell completion request, if main got one
+       *
+       * when argv[1] is "--__complete", argv[2] is the index of the <br>
+       * word to complete among the words argv[3] onward. the matches <br>
+       * are written one per line and true is returned; otherwise <br>
+       * nothing happens and false is returned. see doc/completion.md <br>
+       */
+      bool serve_completion(int, const char * const *, std::ostream&) const;
+      bool serve_completion(int, const char * const *) const;
+
+      /**
+       * \fn std::uint64_t generation() const
+       * \brief a number that changes whenever the Command is modified
+       *
+       * option(), command(), configure(), clear() and the constraints <br>
+       * all change it, on this Command, its base or any of their <br>
+       * subcommands, so anything derived from a parse can tell when <br>
+       * it is stale. <br>
+       */
+      std::uint64_t generation() const noexcept;
+
+      /**
+       * \fn Command clone() const
+       * \brief copy the Command along with every subcommand
+       *
+       * a plain copy shares its subcommands with the original; <br>
+       * changes to the subcommands of a clone leave the original <br>
+       * alone. options are shared, as they do not change once <br>
+       * declared. <br>
+       */
+      Command clone() const;
+
       /**
        * \fn bool empty() const
        * \brief tests whether the parser has any registered options
@@ -210,14 +373,117 @@ namespace cli {
        */
       bool handle_has_name(const std::string&, const std::string&) const;
 
+      /**
+       * \fn std::vector<std::string> suggest(const std::string&) const
+       * \brief find declared handles close to a mistyped one
+       *
+       * handles within a few edits of the argument are returned, <br>
+       * nearest first. anything after an '=' is ignored. the index <br>
+       * searched is kept up to date by option() and clear(). <br>
+       */
+      std::vector<std::string> suggest(const std::string&) const;
+
+      /**
+       * \fn Memory_Usage memory_usage() const
+       * \brief estimate the memory held by the option tables
+       *
+       * counts handles, names, ids, the indices over handles and the <br>
+       * options themselves, but not subcommands. <br>
+       */
+      Memory_Usage memory_usage() const;
+
     private:
+      friend class Session;
+
+      using handle_map_t = std::unordered_map<std::string, std::shared_ptr<Option>>;
+      using Id_Set       = std::vector<std::uint64_t>; // bit n is option id n
+
+      enum class Rule_Kind : std::uint8_t {
+        REQUIRED, DEPENDS, CONFLICTS, AT_LEAST_ONE, EXACTLY_ONE
+      };
+
+      // a constraint; subject is -1 for those over a group alone
+      struct Rule {
+        Rule_Kind kind;
+        int subject;
+        Id_Set group;
+      };
+
+      // options found so far by a parse, for checking the rules
+      struct Presence {
+        Id_Set present;
+        std::vector<int> seen; // index of the first use of each id, or -1
+
+        void mark(const Option&, int);
+      };
+
+      // the words a subcommand did not consume, for the command above it
+      struct Leftover {
+        std::vector<int> words; // in order, before tail
+        int tail;               // every word from here on, after "--"
+      };
+
+      struct Reporter;
+
+      using Handle_List = std::vector<std::pair<std::string, std::shared_ptr<Option>>>;
+
+      static std::shared_ptr<Option> compile(const std::string&, const std::string&,
+                                             Handle_List&);
+      void install(const std::shared_ptr<Option>&, const Handle_List&, bool);
+      void parse_into(char **, int, Info *, Diagnostics *, int, Leftover *,
+                      Presence * = nullptr) const;
+      static bool store(const Option&, std::string, int, std::size_t, Info *,
+                        const Reporter&);
+      static int compact(char **, int);
+      std::shared_ptr<Option> bindable(const std::string&) const;
+      void parse_sources_into(char **, int, const std::string&, Info *,
+                              Diagnostics *) const;
+      template <typename Apply>
+      void read_config(std::string_view, const std::string&, Info *, Diagnostics *,
+                       std::unordered_set<const Option *>&, Apply&&) const;
+      void add_rule(Rule_Kind, const std::string *, const std::vector<std::string>&);
+      void check_rules(const Presence&, int, Diagnostics *) const;
+      const handle_map_t::value_type * find_option(const std::string&,
+                                                   std::string::size_type, bool&) const;
+      const handle_map_t::value_type * find_abbreviation(const std::string&, bool&) const;
+      const handle_map_t::value_type * find_handle(const std::string&) const;
+      int find_id(const std::string&) const;
+      int id_count() const noexcept;
+      void check_unshared() const;
+      std::vector<std::string> prefixed(const std::string&) const;
+      static Error_Code verify(const std::string&, const Option&);
+      static Error_Code verify_entry(const std::string&, const Option&, std::size_t&);
+
       std::string name;
       std::unordered_map<std::string, std::shared_ptr<Command>> commands;
-      std::unordered_map<std::string, std::shared_ptr<Option>> handles;
+      std::shared_ptr<const Command> base; // options looked up after handles
+      int first_id;                        // ids below this belong to base
+      handle_map_t handles;
+      std::unordered_map<std::string, int> ids;
+      std::vector<std::string> names;
+      BK_Tree handle_index;
+      Prefix_Index handle_prefixes;
+      Prefix_Index command_prefixes;
+      Prefix_Trie patterns; // handles of STUCK and PREFIX options
+      std::vector<Rule> rules;
+      Flat_Map env_names;    // variable to option name
+      Flat_Map config_names; // config key to option name
+      std::unordered_map<std::string, std::shared_ptr<Option>> bound;
       bool is_case_sensitive;
       bool is_bsd_opt_enabled;
       bool is_merged_opt_enabled;
       bool is_error_unknown_enabled;
+      bool is_abbrev_enabled;
+      std::uint64_t revision; // stamp of the last change to this Command
+
+      // set once this Command is the base of another. a copy is not shared
+      struct Shared_Mark {
+        mutable std::atomic<bool> is_set{ false };
+
+        Shared_Mark() = default;
+        Shared_Mark(const Shared_Mark&) noexcept {}
+        Shared_Mark& operator=(const Shared_Mark&) noexcept { return *this; }
+      } shared;
   };
 
   /**
@@ -226,14 +492,23 @@ namespace cli {
    */
   class parse_error: std::exception {
     public:
-      parse_error(std::string&& msg): data(std::move(msg)) {}
+      parse_error(std::string&& msg): data(std::move(msg)),
+                                      error(Error_Code::NONE) {}
+
+      parse_error(Error_Code code, std::string&& msg): data(std::move(msg)),
+                                                       error(code) {}
 
       const char* what() const noexcept override {
         return data.c_str();
       }
 
+      Error_Code code() const noexcept {
+        return error;
+      }
+
     private:
       std::string data;
+      Error_Code error;
   };
 
   /**
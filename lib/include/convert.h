@@ -0,0 +1,46 @@
+/**
+ * \file convert.h
+ *
+ * \author Adam Marshall (ih8celery)
+ *
+ * \brief validate and convert numeric option arguments in one pass
+ */
+#ifndef _MOD_CPP_COMMAND_PARSE_CONVERT
+
+#define _MOD_CPP_COMMAND_PARSE_CONVERT
+
+#include <cstdint>
+#include <string_view>
+
+namespace cli {
+  /**
+   * \enum Conversion
+   * \brief result of converting an argument to a number
+   */
+  enum class Conversion {
+    OK, BAD_FORMAT, OUT_OF_RANGE
+  };
+
+  /**
+   * \fn Conversion to_integer(std::string_view, std::int64_t&)
+   * \brief validate and convert an argument declared with type 'i'
+   *
+   * <integer> := <ws><sign><radix><digits><suffix><ws> <br>
+   * <sign>    := '+'|'-'|<nil> <br>
+   * <radix>   := '0x'|'0X'|'0o'|'0O'|'0b'|'0B'|<nil> <br>
+   * <suffix>  := 'k'|'K'|'m'|'M'|'g'|'G'|<nil> // powers of 1024 <br>
+   * the result is written only when OK is returned <br>
+   */
+  Conversion to_integer(std::string_view, std::int64_t&) noexcept;
+
+  /**
+   * \fn Conversion to_float(std::string_view, double&)
+   * \brief validate and convert an argument declared with type 'f'
+   *
+   * accepts an optional sign followed by a decimal number with an <br>
+   * optional fraction and exponent. inf and nan are rejected. <br>
+   */
+  Conversion to_float(std::string_view, double&) noexcept;
+}
+
+#endif
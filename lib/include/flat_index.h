@@ -0,0 +1,77 @@
+/**
+ * \file flat_index.h
+ *
+ * \author Adam Marshall (ih8celery)
+ *
+ * \brief open-addressing table of indices into an array kept elsewhere
+ */
+#ifndef _MOD_CPP_COMMAND_PARSE_FLAT_INDEX
+
+#define _MOD_CPP_COMMAND_PARSE_FLAT_INDEX
+
+#include <string_view>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace cli {
+  /**
+   * \class Flat_Index
+   * \brief finds items of an array by a string key
+   *
+   * the owner keeps the items in order of insertion and numbers them <br>
+   * from 0; the index keeps only their hashes and a table of their <br>
+   * numbers, searched by linear probing. find is given a function <br>
+   * from an item number to its key. the index of Flat_Map and <br>
+   * Value_Pool. <br>
+   */
+  class Flat_Index {
+    public:
+      static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+      /**
+       * \fn std::size_t hash(std::string_view)
+       * \brief the hash of a key, as find and add expect it
+       */
+      static std::size_t hash(std::string_view) noexcept;
+
+      /**
+       * \fn std::size_t find(std::string_view, std::size_t, Key_Of) const
+       * \brief the number of the item with a key and its hash, or npos
+       */
+      template <typename Key_Of>
+      std::size_t find(std::string_view key, std::size_t hash, Key_Of key_of) const noexcept {
+        if (slots.empty()) {
+          return npos;
+        }
+
+        std::size_t mask = slots.size() - 1;
+
+        for (std::size_t at = hash & mask; slots[at] != 0; at = (at + 1) & mask) {
+          std::size_t item = slots[at] - 1;
+
+          if (hashes[item] == hash && key_of(item) == key) {
+            return item;
+          }
+        }
+
+        return npos;
+      }
+
+      /**
+       * \fn std::size_t add(std::size_t)
+       * \brief number the next item, whose key must be absent
+       *
+       * takes the hash of its key and returns its number <br>
+       */
+      std::size_t add(std::size_t);
+
+    private:
+      void grow();
+
+      std::vector<std::size_t> hashes;  // hash of the key of each item
+      std::vector<std::uint32_t> slots; // 0 when empty, otherwise item + 1
+  };
+}
+
+#endif
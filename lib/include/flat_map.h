@@ -0,0 +1,88 @@
+/**
+ * \file flat_map.h
+ *
+ * \author Adam Marshall (ih8celery)
+ *
+ * \brief open-addressing map holding the keys and values of a map option
+ */
+#ifndef _MOD_CPP_COMMAND_PARSE_FLAT_MAP
+
+#define _MOD_CPP_COMMAND_PARSE_FLAT_MAP
+
+#include "flat_index.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+
+namespace cli {
+  /**
+   * \class Flat_Map
+   * \brief map from string to string in two flat arrays
+   *
+   * entries are kept in order of first insertion and found through <br>
+   * a Flat_Index. lookups take a string_view, so no string is built <br>
+   * to search. entries are never removed, and copies of the map <br>
+   * stay valid. <br>
+   */
+  class Flat_Map {
+    public:
+      using entry_type = std::pair<std::string, std::string>;
+
+      /**
+       * \fn const std::string * find(std::string_view) const
+       * \brief the value stored under a key, or nullptr
+       */
+      const std::string * find(std::string_view) const noexcept;
+
+      /**
+       * \fn bool contains(std::string_view) const
+       * \brief tests whether a key is stored
+       */
+      bool contains(std::string_view) const noexcept;
+
+      /**
+       * \fn void assign(std::string_view, std::string_view)
+       * \brief store a value under a key, replacing any value there
+       */
+      void assign(std::string_view, std::string_view);
+
+      /**
+       * \fn bool emplace(std::string_view, std::string_view)
+       * \brief store a value under a key unless the key is stored
+       *
+       * returns true if the value was stored <br>
+       */
+      bool emplace(std::string_view, std::string_view);
+
+      /**
+       * \fn const std::vector<entry_type>& entries() const
+       * \brief every key and value, in order of first insertion
+       */
+      const std::vector<entry_type>& entries() const noexcept;
+
+      /**
+       * \fn std::size_t size() const
+       * \brief number of keys stored
+       */
+      std::size_t size() const noexcept;
+
+      /**
+       * \fn bool empty() const
+       * \brief tests whether any keys are stored
+       */
+      bool empty() const noexcept;
+
+    private:
+      std::size_t search(std::string_view, std::size_t) const noexcept;
+      void insert(std::string_view, std::string_view, std::size_t);
+
+      std::vector<entry_type> items;
+      Flat_Index index;
+  };
+}
+
+#endif
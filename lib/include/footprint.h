@@ -0,0 +1,34 @@
+/**
+ * \file footprint.h
+ *
+ * \author Adam Marshall (ih8celery)
+ *
+ * \brief estimates of the heap memory held by the library's tables
+ */
+#ifndef _MOD_CPP_COMMAND_PARSE_FOOTPRINT
+
+#define _MOD_CPP_COMMAND_PARSE_FOOTPRINT
+
+#include <string>
+#include <cstddef>
+
+/*
+ * used by Command::memory_usage and the bytes of the indexes it keeps.
+ * the figures follow libstdc++ and are estimates, not counts of what
+ * the allocator handed out
+ */
+namespace cli {
+  // bytes a string holds outside itself; short ones are kept inline
+  inline std::size_t heap_bytes(const std::string& str) noexcept {
+    return (str.capacity() > std::string().capacity()) ? str.capacity() + 1 : 0;
+  }
+
+  // an unordered_map: its buckets, plus one node per entry
+  template <typename Map>
+  std::size_t table_bytes(const Map& map) noexcept {
+    return map.bucket_count() * sizeof(void *)
+         + map.size() * (sizeof(typename Map::value_type) + 2 * sizeof(void *));
+  }
+}
+
+#endif
@@ -9,12 +9,17 @@
 #define _MOD_CPP_COMMAND_PARSE_INFO
 
 #include "option.h"
+#include "flat_map.h"
+#include "value_pool.h"
 
 #include <unordered_map>
+#include <algorithm>
 #include <set>
 #include <string>
+#include <string_view>
 #include <optional>
 #include <vector>
+#include <cstdint>
 
 namespace cli {
     using opt_data_t = std::unordered_multimap<std::string, std::string>;
@@ -51,12 +56,107 @@ namespace cli {
        */
       std::optional<std::vector<std::string>> find_all(const std::string&) const;
 
+      /**
+       * \fn optional<int64_t> find_integer(const string&)
+       * \brief retrieve value of option converted to an integer
+       *
+       * options declared "i" are converted while parsing and read <br>
+       * back as they were kept; the text of other options is <br>
+       * converted here. see to_integer in convert.h for the <br>
+       * accepted forms <br>
+       */
+      std::optional<std::int64_t> find_integer(const std::string&) const;
+
+      /**
+       * \fn optional<double> find_float(const string&)
+       * \brief retrieve value of option converted to a float
+       */
+      std::optional<double> find_float(const std::string&) const;
+
+      /**
+       * \fn const vector<int64_t> * find_integers(const string&)
+       * \brief retrieve every element given to an integer list option
+       *
+       * values of options declared "i" or "[i]" are converted while <br>
+       * parsing and kept in one vector; find and find_all give them <br>
+       * as they were written. nullptr if the option was not found <br>
+       */
+      const std::vector<std::int64_t> * find_integers(const std::string&) const;
+
+      /**
+       * \fn const vector<double> * find_floats(const string&)
+       * \brief retrieve every element given to a float list option
+       */
+      const std::vector<double> * find_floats(const std::string&) const;
+
+      /**
+       * \fn void intern_values()
+       * \brief keep each distinct element of a string list once
+       *
+       * call on an Info before passing it to parse. elements of <br>
+       * lists declared "[s]" that parse finds afterward go to a <br>
+       * Value_Pool, and the lists hold their ids, so memory grows <br>
+       * with the distinct values rather than with every use. find, <br>
+       * find_all and the others see the elements as before. <br>
+       */
+      void intern_values() noexcept;
+
+      /**
+       * \fn const vector<uint32_t> * find_ids(const string&)
+       * \brief retrieve the ids of the elements of an interned list
+       *
+       * look the ids up in values(). nullptr if the option was not <br>
+       * found or its list was not interned <br>
+       */
+      const std::vector<std::uint32_t> * find_ids(const std::string&) const;
+
+      /**
+       * \fn const Value_Pool& values() const
+       * \brief the pool holding the elements of interned lists
+       */
+      const Value_Pool& values() const noexcept;
+
+      /**
+       * \fn optional<string_view> lookup(const string&, string_view)
+       * \brief retrieve the value of a key given to a map option
+       *
+       * the view lasts as long as the Info it came from <br>
+       */
+      std::optional<std::string_view> lookup(const std::string&, std::string_view) const;
+
+      /**
+       * \fn const Flat_Map * find_map(const string&)
+       * \brief retrieve every key and value given to a map option
+       */
+      const Flat_Map * find_map(const std::string&) const;
+
       /**
        * \fn opt_data_t::size_type count(const string&)
        * \brief count occurrences of option during parsing
+       *
+       * for a map option, the number of keys <br>
        */
       opt_data_t::size_type count(const std::string&) const;
 
+      /**
+       * \fn std::string serialize() const
+       * \brief write the Info into one flat, relocatable buffer
+       *
+       * names and values go to a pool of strings addressed by <br>
+       * offset, so the bytes may be copied to shared memory or sent <br>
+       * to another process and read there in place by Info_View. <br>
+       * see info_view.h <br>
+       */
+      std::string serialize() const;
+
+      /**
+       * \fn static Info deserialize(const void *, std::size_t)
+       * \brief rebuild an Info from the bytes made by serialize
+       *
+       * throws std::invalid_argument as the Info_View constructor <br>
+       */
+      static Info deserialize(const void *, std::size_t);
+
       /**
        * \var vector<string> rest
        * \brief contains non-options found during parsing
@@ -64,7 +164,60 @@ namespace cli {
       std::vector<std::string> rest;
 
     private:
+      /*
+       * numbers as they were written: the arguments they were taken from,
+       * and where each number lies in its argument. an argument is far
+       * shorter than 4GB, so its offsets fit in 32 bits
+       */
+      struct Number_Text {
+        struct Span {
+          std::uint32_t begin;
+          std::uint32_t end;
+        };
+
+        std::vector<std::string> words;
+        std::vector<std::size_t> ends;
+        std::vector<Span> spans;
+
+        void reserve(std::size_t numbers) { spans.reserve(numbers); }
+
+        // a number found in the argument that keep is given next
+        void push_back(std::size_t begin, std::size_t end) {
+          spans.push_back({ static_cast<std::uint32_t>(begin),
+                            static_cast<std::uint32_t>(end) });
+        }
+
+        // hold on to the argument of the numbers pushed since the last keep
+        void keep(std::string word) {
+          if (spans.size() > (ends.empty() ? 0 : ends.back())) {
+            words.push_back(std::move(word));
+            ends.push_back(spans.size());
+          }
+        }
+
+        std::string_view operator[](std::size_t i) const noexcept {
+          std::size_t word = (words.size() == 1) ? 0
+                           : std::upper_bound(ends.cbegin(), ends.cend(), i) - ends.cbegin();
+
+          return std::string_view(words[word]).substr(spans[i].begin,
+                                                      spans[i].end - spans[i].begin);
+        }
+
+        std::size_t size() const noexcept { return spans.size(); }
+      };
+
+      std::optional<std::string_view> find_text(const std::string&) const;
+      const Number_Text * find_number_text(const std::string&) const;
+      void forget(const std::string&);
+
       opt_data_t data;
+      std::unordered_map<std::string, Flat_Map> maps;
+      std::unordered_map<std::string, std::vector<std::int64_t>> integer_lists;
+      std::unordered_map<std::string, std::vector<double>> float_lists;
+      std::unordered_map<std::string, Number_Text> number_text;
+      std::unordered_map<std::string, std::vector<std::uint32_t>> interned_lists;
+      Value_Pool pool;
+      bool is_interning = false;
       std::set<std::string> commands;
   };
 }
@@ -0,0 +1,119 @@
+/**
+ * \file info_view.h
+ *
+ * \author Adam Marshall (ih8celery)
+ *
+ * \brief read an Info in place from the bytes made by Info::serialize
+ */
+#ifndef _MOD_CPP_COMMAND_PARSE_INFO_VIEW
+
+#define _MOD_CPP_COMMAND_PARSE_INFO_VIEW
+
+#include "info.h"
+
+#include <string>
+#include <string_view>
+#include <optional>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace cli {
+  /**
+   * \class Number_View
+   * \brief the elements of a typed list, read where they lie
+   */
+  template <typename T>
+  class Number_View {
+    public:
+      Number_View() noexcept: first(nullptr), count(0) {}
+      Number_View(const T * data, std::size_t size) noexcept: first(data), count(size) {}
+
+      const T * begin() const noexcept { return first; }
+      const T * end() const noexcept { return first + count; }
+      const T& operator[](std::size_t i) const noexcept { return first[i]; }
+      std::size_t size() const noexcept { return count; }
+      bool empty() const noexcept { return count == 0; }
+
+    private:
+      const T * first;
+      std::size_t count;
+  };
+
+  /**
+   * \class Info_View
+   * \brief read-only Info over a buffer, without copying it
+   *
+   * the buffer holds the bytes of Info::serialize, for example in <br>
+   * memory shared with the process that parsed. construction checks <br>
+   * only the header, so it costs the same for any size of Info; the <br>
+   * rest is trusted to be as serialize wrote it. the buffer must be <br>
+   * aligned to 8 bytes and outlive the view and everything read <br>
+   * from it. numbers are stored in the byte order of the machine. <br>
+   * names are found by binary search. values of 'i' and 'f' are read <br>
+   * converted with find_integers and find_floats, and as they were <br>
+   * written with find and find_all. <br>
+   */
+  class Info_View {
+    public:
+      /**
+       * \fn Info_View(const void *, std::size_t)
+       * \brief view the serialized Info at the start of a buffer
+       *
+       * throws std::invalid_argument if the buffer is too small, <br>
+       * misaligned or not made by serialize. <br>
+       */
+      Info_View(const void *, std::size_t);
+
+      bool has(const std::string&) const;
+      bool has_command(const std::string&) const;
+      std::optional<std::string_view> find(const std::string&) const;
+      std::vector<std::string_view> find_all(const std::string&) const;
+      std::size_t count(const std::string&) const;
+      Number_View<std::int64_t> find_integers(const std::string&) const;
+      Number_View<double> find_floats(const std::string&) const;
+      std::optional<std::string_view> lookup(const std::string&, std::string_view) const;
+
+      /**
+       * \fn std::size_t rest_size() const
+       * \brief number of words in Info::rest; rest(i) gives each
+       */
+      std::size_t rest_size() const noexcept;
+      std::string_view rest(std::size_t) const;
+
+      /**
+       * \fn std::size_t size() const
+       * \brief number of bytes of the buffer that belong to the view
+       */
+      std::size_t size() const noexcept;
+
+    private:
+      friend class Info;
+
+      enum class Kind : std::uint32_t { STRINGS, MAP, INTEGERS, FLOATS };
+
+      struct Record {
+        std::string_view name;
+        Kind kind;
+        std::uint32_t count;
+        std::uint32_t items;
+        std::uint32_t order;
+      };
+
+      Record record(std::uint32_t) const noexcept;
+      std::uint32_t first_record(std::string_view) const noexcept;
+      const Record * find_record(std::string_view, Kind, Record&) const noexcept;
+      std::string_view string_at(std::uint32_t) const noexcept;
+      std::uint32_t text_at(const Record&) const noexcept;
+      std::uint32_t read(std::uint32_t) const noexcept;
+
+      const char * base;
+      std::uint32_t bytes;
+      std::uint32_t option_count, options;
+      std::uint32_t rest_count, rest_at;
+      std::uint32_t command_count, commands;
+      std::uint32_t pool;
+  };
+}
+
+#endif
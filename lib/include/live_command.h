@@ -0,0 +1,78 @@
+/**
+ * \file live_command.h
+ *
+ * \author Adam Marshall (ih8celery)
+ *
+ * \brief a Command that may be changed while other threads parse with it
+ */
+#ifndef _MOD_CPP_COMMAND_PARSE_LIVE_COMMAND
+
+#define _MOD_CPP_COMMAND_PARSE_LIVE_COMMAND
+
+#include "cmdparse.h"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+
+namespace cli {
+  /**
+   * \class Live_Command
+   * \brief publishes immutable versions of a Command to parsing threads
+   *
+   * a Command must not change while it parses. a writer edits a <br>
+   * private copy of the current version and publishes it with a <br>
+   * stamp that no other version of any Live_Command has. each thread <br>
+   * remembers the last few versions it took with their stamps, so <br>
+   * snapshot usually costs one atomic load and a reference count; <br>
+   * only the first snapshot after a publish takes a short lock, <br>
+   * never the one a writer holds while it edits. readers hold a <br>
+   * version for as long as they parse, and a version is freed once <br>
+   * no reader holds it and no thread remembers it. writers are <br>
+   * serialized with each other. <br>
+   */
+  class Live_Command {
+    public:
+      /**
+       * \fn Live_Command(const Command& = Command())
+       * \brief publish a copy of a Command as the first version
+       */
+      Live_Command(const Command& = Command());
+
+      /**
+       * \fn shared_ptr<const Command> snapshot() const
+       * \brief the current version, kept alive while it is held
+       */
+      std::shared_ptr<const Command> snapshot() const;
+
+      /**
+       * \fn void update(const function<void(Command&)>&)
+       * \brief change a copy of the current version, then publish it
+       *
+       * the copy shares no subcommand with the published version. <br>
+       * if the function throws, nothing is published and the <br>
+       * exception is passed on. returns once the new version is the <br>
+       * one snapshot gives. <br>
+       */
+      void update(const std::function<void(Command&)>&);
+
+      /**
+       * \fn Info parse(char **, int) const
+       * \brief parse with the current version
+       *
+       * also available with Diagnostics <br>
+       */
+      Info parse(char **, int) const;
+      Info parse(char **, int, Diagnostics&) const;
+
+    private:
+      std::shared_ptr<const Command> current; // guarded by guard
+      std::atomic<std::uint64_t> stamp;       // stamp of current
+      mutable std::mutex guard;               // held while current is swapped
+      std::mutex writer;                      // held for a whole update
+  };
+}
+
+#endif
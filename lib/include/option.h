@@ -9,6 +9,8 @@
 #define _MOD_CPP_COMMAND_PARSE_OPTION
 
 #include <string>
+#include <vector>
+#include <cstdint>
 
 namespace cli {
   namespace Property {
@@ -33,9 +35,13 @@ namespace cli {
      *              | '=?'  // Assignment::EQ_MAYBE <br>
      *              | '=!'  // Assignment::EQ_NEVER <br>
      *              | '=|'  // Assignment::STUCK_ARG <br>
+     *              | '=&'  // Assignment::PREFIX <br>
+     * STUCK takes one handle of form /-[A-Z]/; PREFIX handles may be <br>
+     * any prefixed word, such as "-D" or "--define-". either kind <br>
+     * takes the rest of the word that begins with it as its argument. <br>
      */
     enum class Assignment {
-      NO_ASSIGN, EQ_REQUIRED, EQ_MAYBE, EQ_NEVER, STUCK
+      NO_ASSIGN, EQ_REQUIRED, EQ_MAYBE, EQ_NEVER, STUCK, PREFIX
     };
     
     /**
@@ -44,9 +50,24 @@ namespace cli {
      *
      * <collection> := <nil>            // Collection::SCALAR <br>
      *              | '['<data_prop>']' // Collection::LIST <br>
+     *              | '{'<data_prop>':'<data_prop><duplicates>'}' <br>
+     *                                  // Collection::MAP <br>
+     * a MAP argument is "key=value"; the first type is of the key <br>
      */
     enum class Collection {
-      SCALAR, LIST
+      SCALAR, LIST, MAP
+    };
+
+    /**
+     * \enum Duplicate_Key
+     * \brief what a MAP option does with a key given again
+     *
+     * <duplicates> := <nil> // Duplicate_Key::LAST, the later value wins <br>
+     *              | '?'    // Duplicate_Key::FIRST, the later is ignored <br>
+     *              | '!'    // Duplicate_Key::ERROR <br>
+     */
+    enum class Duplicate_Key {
+      LAST, FIRST, ERROR
     };
     
     /**
@@ -57,6 +78,7 @@ namespace cli {
      *             | 's'   // Arg_Type::STRING <br>
      *             | 'i'   // Arg_Type::INTEGER <br>
      *             | 'f'   // Arg_Type::FLOAT <br>
+     * see convert.h for the numbers accepted by 'i' and 'f' <br>
      */
     enum class Arg_Type {
       STRING, INTEGER, FLOAT
@@ -77,6 +99,29 @@ namespace cli {
       Property::Arg_Type type;
       std::string name;
 
+      // type of the keys and handling of repeated keys of a MAP option
+      Property::Arg_Type key_type;
+      Property::Duplicate_Key duplicates;
+
+      // index of name within the declaring Command, -1 until declared
+      int id;
+
+      // set on the "--no-" handles of a flag declared with '!'
+      bool negated;
+
+      /**
+       * \brief constraint following the arg type in the spec
+       *
+       * <constraint> := <nil> <br>
+       *              | '{'<number>'..'<number>'}' // range of 'i' or 'f' <br>
+       *              | '{'<choice_list>'}'        // choices of 's' <br>
+       * either end of a range may be omitted to leave it unbounded. <br>
+       * choices are kept sorted for binary search during parsing. <br>
+       */
+      std::int64_t int_min, int_max;
+      double float_min, float_max;
+      std::vector<std::string> choices;
+
       friend bool operator<(const Option&, const Option&) noexcept;
       friend bool operator==(const Option&, const Option&) noexcept;
   };
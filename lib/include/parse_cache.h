@@ -0,0 +1,95 @@
+/**
+ * \file parse_cache.h
+ *
+ * \author Adam Marshall (ih8celery)
+ *
+ * \brief remembers the results of parsing the same words again
+ */
+#ifndef _MOD_CPP_COMMAND_PARSE_PARSE_CACHE
+
+#define _MOD_CPP_COMMAND_PARSE_PARSE_CACHE
+
+#include "cmdparse.h"
+
+#include <unordered_map>
+#include <list>
+#include <memory>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+namespace cli {
+  /**
+   * \class Parse_Cache
+   * \brief bounded cache of parses, least recently used dropped first
+   *
+   * for programs that parse the same lines over and over, such as a <br>
+   * shell running a script in a loop. words are looked up by a hash <br>
+   * and then compared in full, so a collision never returns the <br>
+   * wrong Info. every entry is dropped when the Command changes. a <br>
+   * parse that fails is not cached. not safe to share between <br>
+   * threads; the Command must outlive the cache. <br>
+   */
+  class Parse_Cache {
+    public:
+      /**
+       * \fn Parse_Cache(const Command&, std::size_t = 64)
+       * \brief cache up to the given number of parses of a Command
+       */
+      Parse_Cache(const Command&, std::size_t = 64);
+
+      /**
+       * \fn shared_ptr<const Info> parse(const char * const *, int)
+       * \brief the Info of parsing the words, parsed only if not cached
+       *
+       * argv is never written. throws a parse_error as Command::parse <br>
+       */
+      std::shared_ptr<const Info> parse(const char * const *, int);
+
+      /**
+       * \fn std::size_t hits() const
+       * \brief number of calls to parse answered from the cache
+       */
+      std::size_t hits() const noexcept;
+
+      /**
+       * \fn std::size_t misses() const
+       * \brief number of calls to parse that had to parse
+       */
+      std::size_t misses() const noexcept;
+
+      /**
+       * \fn std::size_t size() const
+       * \brief number of parses held
+       */
+      std::size_t size() const noexcept;
+
+      /**
+       * \fn void clear()
+       * \brief drop every entry; the counters are kept
+       */
+      void clear() noexcept;
+
+    private:
+      struct Entry {
+        std::uint64_t hash;
+        std::string words; // the words, each followed by '\0'
+        std::shared_ptr<const Info> info;
+      };
+
+      using entry_list_t = std::list<Entry>;
+
+      static std::uint64_t hash_words(const char * const *, int) noexcept;
+      static bool same_words(const std::string&, const char * const *, int) noexcept;
+
+      const Command& command;
+      std::size_t capacity;
+      std::uint64_t generation;
+      entry_list_t entries; // most recently used first
+      std::unordered_multimap<std::uint64_t, entry_list_t::iterator> index;
+      std::size_t hit_count;
+      std::size_t miss_count;
+  };
+}
+
+#endif
@@ -0,0 +1,135 @@
+/**
+ * \file prefix.h
+ *
+ * \author Adam Marshall (ih8celery)
+ *
+ * \brief prefix queries over handles
+ */
+#ifndef _MOD_CPP_COMMAND_PARSE_PREFIX
+
+#define _MOD_CPP_COMMAND_PARSE_PREFIX
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <atomic>
+#include <mutex>
+
+namespace cli {
+  /**
+   * \class Prefix_Index
+   * \brief set of strings kept sorted so that every string sharing a
+   *        prefix lies in one contiguous range
+   *
+   * inserted strings wait in a list and are sorted into the index by <br>
+   * the next query, so declaring n handles costs O(n log n) however <br>
+   * they arrive, and nothing when no query is made. queries from <br>
+   * several threads at once are safe. <br>
+   */
+  class Prefix_Index {
+    public:
+      using const_iterator = std::vector<std::string>::const_iterator;
+
+      Prefix_Index() = default;
+      Prefix_Index(const Prefix_Index&);
+      Prefix_Index& operator=(const Prefix_Index&);
+
+      /**
+       * \fn void insert(const std::string&)
+       * \brief add a string; duplicates are ignored
+       */
+      void insert(const std::string&);
+
+      /**
+       * \fn void insert(std::vector<std::string>)
+       * \brief add many strings at once
+       */
+      void insert(std::vector<std::string>);
+
+      /**
+       * \fn pair<const_iterator, const_iterator> range(const std::string&) const
+       * \brief find the strings that begin with a prefix
+       *
+       * two binary searches, so O(length * log n) comparisons <br>
+       */
+      std::pair<const_iterator, const_iterator> range(const std::string&) const;
+
+      /**
+       * \fn std::size_t size() const
+       * \brief number of strings stored
+       */
+      std::size_t size() const;
+
+      /**
+       * \fn void clear()
+       * \brief remove every string from the index
+       */
+      void clear() noexcept;
+
+      /**
+       * \fn std::size_t bytes() const
+       * \brief approximate memory held, in bytes
+       */
+      std::size_t bytes() const noexcept;
+
+    private:
+      void flush() const;
+
+      mutable std::vector<std::string> keys;
+      mutable std::vector<std::string> pending; // inserted, not yet in keys
+      mutable std::atomic<bool> is_sorted{ true };
+      mutable std::mutex guard;                 // held while pending is moved
+  };
+
+  /**
+   * \class Prefix_Trie
+   * \brief set of strings answering which of them begin another string
+   *
+   * used for handles that take the rest of the word as their argument, <br>
+   * so a lookup costs one step per character of the word, however <br>
+   * many such handles there are. <br>
+   */
+  class Prefix_Trie {
+    public:
+      /**
+       * \fn void insert(const std::string&)
+       * \brief add a non-empty string
+       */
+      void insert(const std::string&);
+
+      /**
+       * \fn std::size_t longest(const std::string&) const
+       * \brief length of the longest string stored that begins the
+       *        argument, or 0 if there is none
+       */
+      std::size_t longest(const std::string&) const;
+
+      /**
+       * \fn bool empty() const
+       * \brief tests whether any strings are stored
+       */
+      bool empty() const noexcept;
+
+      /**
+       * \fn void clear()
+       * \brief remove every string from the trie
+       */
+      void clear() noexcept;
+
+      /**
+       * \fn std::size_t bytes() const
+       * \brief approximate memory held, in bytes
+       */
+      std::size_t bytes() const noexcept;
+
+    private:
+      struct Node {
+        std::vector<std::pair<char, std::size_t>> children; // character, node
+        bool terminal;
+      };
+
+      std::vector<Node> nodes;
+  };
+}
+
+#endif
@@ -0,0 +1,117 @@
+/**
+ * \file probes.h
+ *
+ * \author Adam Marshall (ih8celery)
+ *
+ * \brief static tracepoints in the parser, for perf and bpftrace
+ */
+#ifndef _MOD_CPP_COMMAND_PARSE_PROBES
+
+#define _MOD_CPP_COMMAND_PARSE_PROBES
+
+#include <cstdint>
+
+/*
+ * each probe is one nop in the code and one note in the ELF section
+ * .note.stapsdt naming the provider "cmdparse", the probe and where
+ * its arguments are, in the format of systemtap's sys/sdt.h. tools
+ * that read the notes put a breakpoint on the nop only while they
+ * trace it. a probe also has a semaphore the tools increment while
+ * attached, so costly arguments are computed only when wanted.
+ *
+ * probes exist when the library is built with CMDPARSE_PROBES (cmake
+ * option ENABLE_PROBES). sys/sdt.h is used if present; otherwise the
+ * notes are written here, for ELF on x86-64 and aarch64. elsewhere
+ * every macro expands to nothing.
+ *
+ * CMDPARSE_SEMAPHORE(name) defines the semaphore of a probe and must
+ * appear at global scope, once per probe, before the probe is used.
+ * arguments are integers, passed on as 8 signed bytes.
+ */
+#if defined(CMDPARSE_PROBES) && defined(__has_include)
+#  if __has_include(<sys/sdt.h>)
+#    define CMDPARSE_PROBES_SDT
+#  elif defined(__ELF__) && defined(__GNUC__) && (defined(__x86_64__) || defined(__aarch64__))
+#    define CMDPARSE_PROBES_NOTE
+#  endif
+#endif
+
+#if defined(CMDPARSE_PROBES_SDT) || defined(CMDPARSE_PROBES_NOTE)
+
+#define CMDPARSE_SEMAPHORE(name)                                                 \
+  __attribute__((section(".probes"), used, visibility("hidden")))                \
+  volatile unsigned short cmdparse_##name##_semaphore = 0
+
+#define CMDPARSE_PROBE_ENABLED(name) \
+  __builtin_expect(cmdparse_##name##_semaphore != 0, 0)
+
+#endif
+
+#if defined(CMDPARSE_PROBES_SDT)
+
+#define _SDT_HAS_SEMAPHORES 1
+#include <sys/sdt.h>
+
+#define CMDPARSE_PROBE1(name, a) \
+  STAP_PROBE1(cmdparse, name, (std::int64_t)(a))
+#define CMDPARSE_PROBE2(name, a, b) \
+  STAP_PROBE2(cmdparse, name, (std::int64_t)(a), (std::int64_t)(b))
+#define CMDPARSE_PROBE3(name, a, b, c) \
+  STAP_PROBE3(cmdparse, name, (std::int64_t)(a), (std::int64_t)(b), (std::int64_t)(c))
+
+#elif defined(CMDPARSE_PROBES_NOTE)
+
+/*
+ * the note holds the address of the nop, of .stapsdt.base (so tools
+ * can tell how far the library was moved when loaded), of the
+ * semaphore, then the provider, the name and the arguments, each
+ * "8@" and the operand as the assembler prints it
+ */
+#define _CMDPARSE_NOTE(name, args)                                               \
+  "990: nop\n"                                                                   \
+  ".pushsection .note.stapsdt,\"?\",\"note\"\n"                                  \
+  ".balign 4\n"                                                                  \
+  ".4byte 992f-991f, 994f-993f, 3\n"                                             \
+  "991: .asciz \"stapsdt\"\n"                                                    \
+  "992: .balign 4\n"                                                             \
+  "993: .8byte 990b\n"                                                           \
+  ".8byte _.stapsdt.base\n"                                                      \
+  ".8byte cmdparse_" #name "_semaphore\n"                                        \
+  ".asciz \"cmdparse\"\n"                                                        \
+  ".asciz \"" #name "\"\n"                                                       \
+  ".asciz \"" args "\"\n"                                                        \
+  "994: .balign 4\n"                                                             \
+  ".popsection\n"                                                                \
+  ".ifndef _.stapsdt.base\n"                                                     \
+  ".pushsection .stapsdt.base,\"aG\",\"progbits\",.stapsdt.base,comdat\n"        \
+  ".weak _.stapsdt.base\n"                                                       \
+  ".hidden _.stapsdt.base\n"                                                     \
+  "_.stapsdt.base: .space 1\n"                                                   \
+  ".size _.stapsdt.base, 1\n"                                                    \
+  ".popsection\n"                                                                \
+  ".endif\n"
+
+#define CMDPARSE_PROBE1(name, a)                                                 \
+  __asm__ __volatile__ (_CMDPARSE_NOTE(name, "8@%[a1]")                          \
+                        :: [a1] "nor" ((std::int64_t)(a)))
+#define CMDPARSE_PROBE2(name, a, b)                                              \
+  __asm__ __volatile__ (_CMDPARSE_NOTE(name, "8@%[a1] 8@%[a2]")                  \
+                        :: [a1] "nor" ((std::int64_t)(a)),                       \
+                           [a2] "nor" ((std::int64_t)(b)))
+#define CMDPARSE_PROBE3(name, a, b, c)                                           \
+  __asm__ __volatile__ (_CMDPARSE_NOTE(name, "8@%[a1] 8@%[a2] 8@%[a3]")          \
+                        :: [a1] "nor" ((std::int64_t)(a)),                       \
+                           [a2] "nor" ((std::int64_t)(b)),                       \
+                           [a3] "nor" ((std::int64_t)(c)))
+
+#else
+
+#define CMDPARSE_SEMAPHORE(name)       static_assert(true, "")
+#define CMDPARSE_PROBE_ENABLED(name)   false
+#define CMDPARSE_PROBE1(name, a)       do {} while (0)
+#define CMDPARSE_PROBE2(name, a, b)    do {} while (0)
+#define CMDPARSE_PROBE3(name, a, b, c) do {} while (0)
+
+#endif
+
+#endif
@@ -0,0 +1,61 @@
+/**
+ * \file registry.h
+ *
+ * \author Adam Marshall (ih8celery)
+ *
+ * \brief options declared by the modules that use them, before main
+ */
+#ifndef _MOD_CPP_COMMAND_PARSE_REGISTRY
+
+#define _MOD_CPP_COMMAND_PARSE_REGISTRY
+
+#include <atomic>
+#include <cstddef>
+
+namespace cli {
+  /**
+   * \class Registration
+   * \brief one option spec waiting for Command::declare_registered
+   *
+   * a Registration with static storage duration pushes itself onto a <br>
+   * list shared by the whole program as it is constructed, with one <br>
+   * compare-and-swap and no allocation, so translation units may <br>
+   * register in any order and from any thread. the strings must <br>
+   * outlive the program, as literals do. see CMDPARSE_DEFINE_OPTION <br>
+   */
+  class Registration {
+    public:
+      Registration(const char *, const char * = "") noexcept;
+
+      Registration(const Registration&)            = delete;
+      Registration& operator=(const Registration&) = delete;
+
+      const char * spec;
+      const char * name;
+
+      /**
+       * \fn static const Registration * first()
+       * \brief the most recent registration; next leads to the earlier
+       */
+      static const Registration * first() noexcept;
+
+      const Registration * next() const noexcept;
+
+    private:
+      Registration * link;
+
+      static std::atomic<Registration *> head;
+  };
+}
+
+/**
+ * \def CMDPARSE_DEFINE_OPTION(id, spec, name)
+ * \brief register an option from any translation unit
+ *
+ * id only needs to be unique within the translation unit. <br>
+ * the options join a Command when it calls declare_registered <br>
+ */
+#define CMDPARSE_DEFINE_OPTION(id, spec, name) \
+  static ::cli::Registration cmdparse_registration_##id(spec, name)
+
+#endif
@@ -0,0 +1,247 @@
+/**
+ * \file session.h
+ *
+ * \author Adam Marshall (ih8celery)
+ *
+ * \brief incremental parse of a line that is being edited
+ */
+#ifndef _MOD_CPP_COMMAND_PARSE_SESSION
+
+#define _MOD_CPP_COMMAND_PARSE_SESSION
+
+#include "cmdparse.h"
+
+#include <unordered_map>
+#include <unordered_set>
+#include <string>
+#include <vector>
+#include <memory>
+#include <set>
+#include <random>
+#include <cstddef>
+#include <cstdint>
+
+namespace cli {
+  /**
+   * \enum Token_Kind
+   * \brief role of a word of the line within the parse
+   */
+  enum class Token_Kind : std::uint8_t {
+    COMMAND,    // name of the command or of a subcommand
+    OPTION,     // handle, possibly followed by '=' and an argument
+    ARGUMENT,   // argument of the option before it
+    POSITIONAL, // word left for Info::rest
+    END         // "-" or "--"; every word after it is POSITIONAL
+  };
+
+  /**
+   * \struct Token
+   * \brief one whitespace-separated word of the line held by a Session
+   *
+   * offset and length locate the word in the line. error is NONE <br>
+   * unless the word has a problem, found at error_offset within it. <br>
+   * option is the id of the option involved, or -1. <br>
+   */
+  struct Token {
+    std::size_t offset;
+    std::size_t length;
+    Token_Kind kind;
+    Error_Code error;
+    std::uint32_t error_offset;
+    std::int32_t option;
+  };
+
+  /**
+   * \class Session
+   * \brief keeps the parse of a line up to date as the line is edited
+   *
+   * each word is matched against the Command once and the result <br>
+   * kept. an edit splits only the words it touches into words again, <br>
+   * and matches only those, along with any words after them whose <br>
+   * meaning depends on them, such as the argument of an option, <br>
+   * and the later words of an option whose earlier ones changed. <br>
+   * a word keeps only its own text and its place among the others, <br>
+   * so an edit costs about the same on a long line as on a short one. <br>
+   * bsd and merged options are not recognized. the Command must <br>
+   * outlive the Session and must not change while it is in use. <br>
+   */
+  class Session {
+    public:
+      /**
+       * \fn Session(const Command&, const std::string& = "")
+       * \brief start a session on a line
+       */
+      Session(const Command&, const std::string& = "");
+
+      /**
+       * \fn Session(const Session&)
+       * \brief start a session on the line of another
+       */
+      Session(const Session&);
+
+      /**
+       * \fn void reset(const std::string&)
+       * \brief replace the whole line, matching every word again
+       */
+      void reset(const std::string&);
+
+      /**
+       * \fn vector<size_t> edit(size_t, size_t, const std::string&)
+       * \brief replace part of the line and update the parse
+       *
+       * the arguments are the offset of the edit, the number of <br>
+       * characters removed there and the text inserted in their place. <br>
+       * returns the indices of the tokens that are new or whose kind, <br>
+       * error or option changed, in order. throws std::out_of_range <br>
+       * if the offset is past the end of the line. <br>
+       */
+      std::vector<std::size_t> edit(std::size_t, std::size_t, const std::string&);
+
+      /**
+       * \fn const std::string& line() const
+       * \brief the current line
+       *
+       * put together on the first call after an edit, in time linear <br>
+       * in the length of the line. valid until the next edit <br>
+       */
+      const std::string& line() const;
+
+      /**
+       * \fn const std::vector<Token>& tokens() const
+       * \brief the words of the current line, in order
+       *
+       * put together on the first call after an edit, in time linear <br>
+       * in the number of words. valid until the next edit <br>
+       */
+      const std::vector<Token>& tokens() const;
+
+      /**
+       * \fn Token token(std::size_t) const
+       * \brief the word at an index, without putting together the rest
+       *
+       * throws std::out_of_range if the index is not less than size() <br>
+       */
+      Token token(std::size_t) const;
+
+      /**
+       * \fn std::size_t size() const
+       * \brief the number of words in the current line
+       */
+      std::size_t size() const noexcept;
+
+      /**
+       * \fn Diagnostics diagnostics() const
+       * \brief the problems of the current line, in order
+       *
+       * as from Command::parse in collect mode, except that index <br>
+       * counts tokens of the line and that only the first problem in <br>
+       * a list is given. a word that is not the subcommand expected <br>
+       * has UNKNOWN_COMMAND before any problem it has as an option; <br>
+       * its token shows the first. a line that ends where a <br>
+       * subcommand is expected has UNKNOWN_COMMAND at index size(). <br>
+       */
+      Diagnostics diagnostics() const;
+
+    private:
+      enum class Expect : std::uint8_t { NAME, COMMAND, OPTION };
+
+      // everything the words before a word tell about its meaning
+      struct State {
+        const Command * command;
+        const Option * pending; // option that takes this word as its argument
+        Expect expect;
+        bool ended;
+        bool repeat;            // pending was repeated, which parse reports here
+
+        bool operator==(const State&) const noexcept;
+        bool operator!=(const State&) const noexcept;
+      };
+
+      // what is kept of a match beside its Token
+      struct Slot {
+        State before;
+        State after;
+        const Option * opt;
+        Error_Code own;            // problem found in the word itself
+        std::uint32_t own_offset;
+        bool seen;                 // option kept here or earlier, since last negated
+        bool dangling;             // last word, but its option wants the next
+        bool stray;                // should name a subcommand, but does not
+      };
+
+      struct Word;
+
+      // orders the words of one option name by position
+      struct Earlier {
+        using is_transparent = void;
+
+        bool operator()(const Word *, const Word *) const;
+        bool operator()(const Word *, std::size_t) const;
+        bool operator()(std::size_t, const Word *) const;
+      };
+
+      using Occurrences = std::set<Word *, Earlier>;
+
+      /*
+       * a word and the whitespace after it, kept in a treap ordered by
+       * position. a node knows the characters and words of its subtree,
+       * which locate it in the line without storing its offset
+       */
+      struct Word {
+        std::string text;
+        Token token; // offset is filled in only when the word is read
+        Slot slot;
+        Occurrences::iterator place; // among the words of its option name
+        std::size_t index;           // while an edit matches the word, else npos
+        Word * left;
+        Word * right;
+        Word * up;
+        std::uint32_t priority;
+        std::size_t chars;
+        std::size_t count;
+      };
+
+      State initial() const noexcept;
+      void match(Word&, const State&);
+      void match_option(Word&, const std::string&);
+      bool check(const std::string&, std::size_t, Slot&) const;
+      bool counts(const Word&) const;
+      bool seen_before(const Word&) const;
+      void mark_dangling(std::vector<std::size_t>&);
+      void refresh(Word&);
+      const Command * parent(const Command *) const;
+
+      Word * make_word(std::string, std::size_t);
+      void release(Word *);
+      static void pull(Word *);
+      static Word * merge(Word *, Word *);
+      static Word * build(const std::vector<Word *>&);
+      static void split(Word *, std::size_t, Word *&, Word *&);
+      static Word * leftmost(Word *);
+      static Word * rightmost(Word *);
+      static Word * next(Word *);
+      static std::size_t rank(const Word *);
+      std::size_t offset_of(const Word *) const;
+      Word * at(std::size_t) const;
+
+      const Command& root;
+      std::unordered_map<const Command *, const Command *> parents;
+      std::unordered_set<std::string> limited; // names of options that may not repeat
+      std::unordered_map<std::string, Occurrences> occurrences;
+      std::string lead;  // whitespace before the first word
+      Word * top;
+      Word * dangling;
+      static constexpr std::size_t block_size = 256;
+
+      std::vector<std::unique_ptr<Word[]>> store; // words are made block_size at a time
+      std::size_t filled;                          // words made in the last block
+      std::vector<Word *> unused;
+      std::minstd_rand priorities;
+      mutable std::string text;
+      mutable std::vector<Token> words;
+      mutable bool text_stale;
+      mutable bool words_stale;
+  };
+}
+
+#endif
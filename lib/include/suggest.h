@@ -0,0 +1,91 @@
+/**
+ * \file suggest.h
+ *
+ * \author Adam Marshall (ih8celery)
+ *
+ * \brief index of handles used to suggest corrections for typos
+ */
+#ifndef _MOD_CPP_COMMAND_PARSE_SUGGEST
+
+#define _MOD_CPP_COMMAND_PARSE_SUGGEST
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <mutex>
+
+namespace cli {
+  /**
+   * \fn std::size_t edit_distance(const std::string&, const std::string&)
+   * \brief levenshtein distance between two strings
+   */
+  std::size_t edit_distance(const std::string&, const std::string&);
+
+  /**
+   * \class BK_Tree
+   * \brief metric tree over strings under edit distance
+   *
+   * finds the strings within n edits of a query while comparing <br>
+   * against a small fraction of the stored strings. inserted strings <br>
+   * wait in a list and join the tree at the next query, since most <br>
+   * programs declare many handles and never ask for a suggestion. <br>
+   * queries from several threads at once are safe. <br>
+   */
+  class BK_Tree {
+    public:
+      BK_Tree() = default;
+      BK_Tree(const BK_Tree&);
+      BK_Tree& operator=(const BK_Tree&);
+
+      /**
+       * \fn void insert(const std::string&)
+       * \brief add a string to the tree; duplicates are ignored
+       */
+      void insert(const std::string&);
+
+      /**
+       * \fn void insert(const std::vector<std::string>&)
+       * \brief add many strings at once
+       */
+      void insert(const std::vector<std::string>&);
+
+      /**
+       * \fn vector<string> query(const std::string&, std::size_t) const
+       * \brief find strings within a distance, nearest first
+       */
+      std::vector<std::string> query(const std::string&, std::size_t) const;
+
+      /**
+       * \fn bool empty() const
+       * \brief tests whether any strings are stored
+       */
+      bool empty() const noexcept;
+
+      /**
+       * \fn void clear()
+       * \brief remove every string from the tree
+       */
+      void clear() noexcept;
+
+      /**
+       * \fn std::size_t bytes() const
+       * \brief approximate memory held, in bytes
+       */
+      std::size_t bytes() const noexcept;
+
+    private:
+      struct Node {
+        std::string key;
+        std::vector<std::pair<std::size_t, std::size_t>> children; // distance, node
+      };
+
+      void add(const std::string&) const;
+      void flush() const;
+
+      mutable std::vector<Node> nodes;
+      mutable std::vector<std::string> pending; // inserted, not yet in nodes
+      mutable std::mutex guard;                 // held while pending is moved
+  };
+}
+
+#endif
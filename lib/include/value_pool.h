@@ -0,0 +1,71 @@
+/**
+ * \file value_pool.h
+ *
+ * \author Adam Marshall (ih8celery)
+ *
+ * \brief set of strings that each get a small, stable id
+ */
+#ifndef _MOD_CPP_COMMAND_PARSE_VALUE_POOL
+
+#define _MOD_CPP_COMMAND_PARSE_VALUE_POOL
+
+#include "flat_index.h"
+
+#include <string>
+#include <string_view>
+#include <optional>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace cli {
+  /**
+   * \class Value_Pool
+   * \brief stores each distinct string once and numbers it
+   *
+   * ids count up from 0 in order of first insertion and never <br>
+   * change, so two values are equal exactly when their ids are. <br>
+   * laid out like Flat_Map: the strings in one array, found <br>
+   * through a Flat_Index. copies of the pool stay valid. <br>
+   */
+  class Value_Pool {
+    public:
+      /**
+       * \fn std::uint32_t intern(std::string_view)
+       * \brief the id of a string, storing it first if it is new
+       */
+      std::uint32_t intern(std::string_view);
+
+      /**
+       * \fn optional<uint32_t> find(std::string_view) const
+       * \brief the id of a string already stored
+       */
+      std::optional<std::uint32_t> find(std::string_view) const noexcept;
+
+      /**
+       * \fn const std::string& value(std::uint32_t) const
+       * \brief the string with an id; the id must have come from intern
+       */
+      const std::string& value(std::uint32_t) const noexcept;
+
+      /**
+       * \fn std::size_t size() const
+       * \brief number of distinct strings stored
+       */
+      std::size_t size() const noexcept;
+
+      /**
+       * \fn bool empty() const
+       * \brief tests whether any strings are stored
+       */
+      bool empty() const noexcept;
+
+    private:
+      std::size_t search(std::string_view, std::size_t) const noexcept;
+
+      std::vector<std::string> items;
+      Flat_Index index;
+  };
+}
+
+#endif
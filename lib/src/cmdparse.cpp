@@ -6,12 +6,105 @@
  * \brief parse command line arguments/options
  */
 #include "cmdparse.h"
+#include "convert.h"
+#include "registry.h"
+#include "probes.h"
+#include "footprint.h"
 #include <sstream>
+#include <string_view>
+#include <algorithm>
 #include <cctype>
+#include <cstdlib>
 #include <iostream>
+#include <system_error>
+#include <bitset>
+#include <chrono>
+#include <exception>
+#include <unordered_set>
+#include <atomic>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+extern char ** environ;
+
+/*
+ * the probes of the parser; see probes.h. all arguments are integers:
+ *   parse__start      argc, index of argv[0] in the outermost argv
+ *   parse__done       argc, problems found, nanoseconds spent (only
+ *                     measured while a tracer is attached)
+ *   option__lookup    index of the word, id of its option or -1; once
+ *                     per letter of a bsd or merged word
+ *   command__dispatch index of the subcommand, words left for it
+ *   list__check       index of the argument, elements kept, rejected
+ *   error             Error_Code, index of the word, option id or -1
+ */
+CMDPARSE_SEMAPHORE(parse__start);
+CMDPARSE_SEMAPHORE(parse__done);
+CMDPARSE_SEMAPHORE(option__lookup);
+CMDPARSE_SEMAPHORE(command__dispatch);
+CMDPARSE_SEMAPHORE(list__check);
+CMDPARSE_SEMAPHORE(error);
 
 namespace cli {
   namespace {
+    /*
+     * stamps for Command::revision. every change takes a stamp larger
+     * than any given before, in any Command, so the largest stamp in a
+     * tree grows even when a change drops the subcommand that held it
+     */
+    std::uint64_t next_revision() noexcept {
+      static std::atomic<std::uint64_t> counter{ 0 };
+
+      return ++counter;
+    }
+
+    // written over each argument parse consumes; told apart by address
+    char consumed_word[] = "";
+
+    // fires parse__start, then parse__done however the parse ends
+    class Probe_Span {
+      public:
+        Probe_Span(int argc, int base, const Diagnostics * diags, bool outermost):
+            argc(argc), diags(diags), outermost(outermost),
+            before(diags ? diags->size() : 0), exceptions(std::uncaught_exceptions()) {
+          if (outermost) {
+            CMDPARSE_PROBE2(parse__start, argc, base);
+
+            if (CMDPARSE_PROBE_ENABLED(parse__done)) {
+              start = std::chrono::steady_clock::now();
+            }
+          }
+        }
+
+        ~Probe_Span() {
+          if (!outermost) {
+            return;
+          }
+
+          std::int64_t problems = diags ? diags->size() - before
+                                        : (std::uncaught_exceptions() > exceptions);
+          std::int64_t elapsed  = 0;
+
+          if (CMDPARSE_PROBE_ENABLED(parse__done)) {
+            elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                          std::chrono::steady_clock::now() - start).count();
+          }
+
+          CMDPARSE_PROBE3(parse__done, argc, problems, elapsed);
+        }
+
+      private:
+        int argc;
+        const Diagnostics * diags;
+        bool outermost;
+        std::size_t before;
+        int exceptions;
+        std::chrono::steady_clock::time_point start;
+    };
+
     inline bool is_prefix_char(char ch) {
       return (ch == ':' || ch == '.' || ch == '-'
                 || ch == '+' || ch == '/');
@@ -35,6 +128,7 @@ namespace cli {
       return result;
     }
 
+    // returns the length of the prefix of in, or -1 if it is malformed
     int skip_prefix(const std::string& in) {
       enum Prefix_State { NONE, MINUS, PLUS, END } state = NONE;
 
@@ -63,7 +157,7 @@ namespace cli {
             break;
           }
           else {
-            throw cli::parse_error(std::string("invalid prefix"));
+            return -1;
           }
         case PLUS:
           if (in[i] == '+') {
@@ -71,259 +165,881 @@ namespace cli {
             break;
           }
           else {
-            throw cli::parse_error(std::string("invalid prefix"));
+            return -1;
           }
         case END:
-          throw cli::parse_error(std::string("invalid prefix"));
+          return -1;
         }
       }
 
       return 0;
     }
     
-    enum class DT_STATE {
-      START,
-      LDIGIT,
-      RDIGIT,
-      DOT,
-      END
-    };
+    Error_Code from_conversion(Conversion result) {
+      switch (result) {
+      case Conversion::OK:
+        return Error_Code::NONE;
+      case Conversion::OUT_OF_RANGE:
+        return Error_Code::OUT_OF_RANGE;
+      default:
+        return Error_Code::BAD_FORMAT;
+      }
+    }
+
+    // convert a numeric argument and test it against the declared range
+    Error_Code convert_number(std::string_view arg, const Option& opt,
+                              std::int64_t& integer) {
+      Conversion result = to_integer(arg, integer);
+
+      if (result != Conversion::OK) {
+        return from_conversion(result);
+      }
+
+      if (integer < opt.int_min || integer > opt.int_max) {
+        return Error_Code::NOT_IN_RANGE;
+      }
+
+      return Error_Code::NONE;
+    }
+
+    Error_Code convert_number(std::string_view arg, const Option& opt, double& real) {
+      Conversion result = to_float(arg, real);
+
+      if (result != Conversion::OK) {
+        return from_conversion(result);
+      }
+
+      if (real < opt.float_min || real > opt.float_max) {
+        return Error_Code::NOT_IN_RANGE;
+      }
 
-    bool verify_arg_type(const std::string& arg, Property::Arg_Type prop) {
-      DT_STATE state = DT_STATE::START;
+      return Error_Code::NONE;
+    }
 
+    /*
+     * convert arg to the type declared by opt and test it against the
+     * declared range or choices, so each argument is scanned only once
+     */
+    Error_Code verify_arg_type(const std::string& arg, const Option& opt) {
       if (arg.empty()) {
-        return false;
+        return Error_Code::BAD_FORMAT;
       }
 
-      switch (prop) {
-      case Property::Arg_Type::STRING:
-        break;
-      case Property::Arg_Type::INTEGER:
-        for (auto i = std::begin(arg); i != std::end(arg); ++i) {
-          switch (state) {
-            case DT_STATE::START:
-              if (i + 1 == std::end(arg) && !isdigit(*i)) {
-                return false;
-              }
-              else if (isdigit(*i)) {
-                state = DT_STATE::LDIGIT;
-              }
-              else if (!isspace(*i)) {
-                return false;
-              }
+      switch (opt.type) {
+      case Property::Arg_Type::INTEGER: {
+        std::int64_t integer;
 
-              break;
-            case DT_STATE::LDIGIT:
-              if (isspace(*i)) {
-                state = DT_STATE::END;
-              }
-              else if (!isdigit(*i)) {
-                return false;
-              }
+        return convert_number(arg, opt, integer);
+      }
+      case Property::Arg_Type::FLOAT: {
+        double real;
 
-              break;
-            case DT_STATE::DOT:
-            case DT_STATE::RDIGIT:
-            case DT_STATE::END:
-              if (!isspace(*i)) {
-                return false;
-              }
+        return convert_number(arg, opt, real);
+      }
+      default:
+        if (!opt.choices.empty()
+            && !std::binary_search(opt.choices.cbegin(), opt.choices.cend(), arg)) {
+          return Error_Code::NOT_A_CHOICE;
+        }
 
-              break;
-          }
+        return Error_Code::NONE;
+      }
+    }
+
+    std::string did_you_mean(const std::vector<std::string>& matches) {
+      constexpr std::size_t MAX_SHOWN = 3;
+      std::string hint;
+
+      if (matches.empty()) {
+        return hint;
+      }
+
+      hint = " (did you mean " + matches[0];
+
+      for (std::size_t i = 1; i < matches.size() && i < MAX_SHOWN; ++i) {
+        hint += " or " + matches[i];
+      }
+
+      return hint + "?)";
+    }
+
+    std::string type_message(const std::string& arg, const Option& opt, Error_Code result) {
+      switch (result) {
+      case Error_Code::OUT_OF_RANGE:
+        return std::string("data '")
+            + arg + "' is out of range for its declared type";
+      case Error_Code::NOT_IN_RANGE:
+        return std::string("data '")
+            + arg + "' is outside the range declared by option '"
+            + opt.name + "'";
+      case Error_Code::NOT_A_CHOICE: {
+        std::string msg = std::string("data '") + arg
+            + "' is not one of the choices declared by option '"
+            + opt.name + "':";
+
+        for (const std::string& choice : opt.choices) {
+          msg += " " + choice;
         }
-      case Property::Arg_Type::FLOAT:
-        for (auto i = std::begin(arg); i != std::end(arg); ++i) {
-          switch (state) {
-            case DT_STATE::START:
-              if (i + 1 == std::end(arg) && !isdigit(*i)) {
-                return false;
-              }
-              else if (isdigit(*i)) {
-                state = DT_STATE::LDIGIT;
-              }
-              else if (!isspace(*i)) {
-                return false;
-              }
 
-              break;
-            case DT_STATE::LDIGIT:
-              if (isspace(*i)) {
-                state = DT_STATE::END;
-              }
-              else if (*i == '.') {
-                state = DT_STATE::DOT;
-              }
-              else if (!isdigit(*i)) {
-                return false;
-              }
+        return msg;
+      }
+      default:
+        return std::string("data '")
+            + arg + "' does not match its declared type";
+      }
+    }
 
-              break;
-            case DT_STATE::DOT:
-              if (i + 1 == std::end(arg) && !isdigit(*i)) {
-                return false;
-              }
-              else if (isdigit(*i)) {
-                state = DT_STATE::RDIGIT;
-              }
-              else {
-                return false;
-              }
+    /*
+     * read the constraint beginning with the '{' at spec[start] into opt.
+     * returns the index of the closing '}'
+     */
+    std::string::size_type read_constraint(const std::string& spec,
+                                           std::string::size_type start,
+                                           Option& opt) {
+      std::string::size_type close = spec.find('}', start);
 
-              break;
-            case DT_STATE::RDIGIT:
-              if (isspace(*i)) {
-                state = DT_STATE::END;
-              }
-              else if (!isdigit(*i)) {
-                return false;
-              }
+      if (close == std::string::npos) {
+        throw option_language_error(std::string("input ended in constraint"));
+      }
 
-              break;
-            case DT_STATE::END:
-              if (!isspace(*i)) {
-                return false;
-              }
+      std::string body = spec.substr(start + 1, close - start - 1);
 
-              break;
+      if (opt.type == Property::Arg_Type::STRING) {
+        std::string::size_type begin = 0;
+
+        while (true) {
+          std::string::size_type comma = body.find(',', begin);
+          std::string choice = body.substr(begin, comma - begin);
+
+          if (choice.empty()) {
+            throw option_language_error(std::string("empty choice in constraint"));
+          }
+
+          opt.choices.push_back(std::move(choice));
+
+          if (comma == std::string::npos) {
+            break;
           }
+
+          begin = comma + 1;
         }
+
+        std::sort(opt.choices.begin(), opt.choices.end());
+        opt.choices.erase(std::unique(opt.choices.begin(), opt.choices.end()),
+                          opt.choices.end());
+
+        return close;
       }
 
-      return true;
+      std::string::size_type dots = body.find("..");
+
+      if (dots == std::string::npos) {
+        throw option_language_error(std::string("expected '..' in range constraint"));
+      }
+
+      std::string low  = body.substr(0, dots);
+      std::string high = body.substr(dots + 2);
+      bool valid;
+
+      if (opt.type == Property::Arg_Type::INTEGER) {
+        valid = (low.empty() || to_integer(low, opt.int_min) == Conversion::OK)
+             && (high.empty() || to_integer(high, opt.int_max) == Conversion::OK)
+             && opt.int_min <= opt.int_max;
+      }
+      else {
+        valid = (low.empty() || to_float(low, opt.float_min) == Conversion::OK)
+             && (high.empty() || to_float(high, opt.float_max) == Conversion::OK)
+             && opt.float_min <= opt.float_max;
+      }
+
+      if (!valid) {
+        throw option_language_error(std::string("invalid range constraint: ") + body);
+      }
+
+      return close;
+    }
+    bool read_type_char(char ch, Property::Arg_Type& type) {
+      switch (ch) {
+      case 's':
+        type = Property::Arg_Type::STRING;
+        return true;
+      case 'i':
+        type = Property::Arg_Type::INTEGER;
+        return true;
+      case 'f':
+        type = Property::Arg_Type::FLOAT;
+        return true;
+      default:
+        return false;
+      }
+    }
+
+    /*
+     * read a map collection such as "{s:i}" or "{s:s!}" beginning with
+     * the '{' at spec[start] into opt. returns the index of the closing
+     * '}', or npos if spec holds a list of choices there instead
+     */
+    std::string::size_type read_map(const std::string& spec,
+                                    std::string::size_type start,
+                                    Option& opt) {
+      Property::Arg_Type key_type, type;
+      std::string::size_type close = start + 4;
+      Property::Duplicate_Key duplicates = Property::Duplicate_Key::LAST;
+
+      if (spec.size() < start + 5 || spec[start + 2] != ':'
+          || !read_type_char(spec[start + 1], key_type)
+          || !read_type_char(spec[start + 3], type)) {
+        return std::string::npos;
+      }
+
+      if (spec[close] == '?') {
+        duplicates = Property::Duplicate_Key::FIRST;
+        ++close;
+      }
+      else if (spec[close] == '!') {
+        duplicates = Property::Duplicate_Key::ERROR;
+        ++close;
+      }
+
+      if (close >= spec.size() || spec[close] != '}') {
+        return std::string::npos;
+      }
+
+      opt.collection = Property::Collection::MAP;
+      opt.key_type   = key_type;
+      opt.type       = type;
+      opt.duplicates = duplicates;
+
+      return close;
+    }
+
+    /*
+     * split the argument of a map option at its first '=' and check both
+     * halves. without an '=', a string value is empty. on error, offset
+     * is where the problem lies within arg
+     */
+    Error_Code verify_map_entry(const std::string& arg, const Option& opt,
+                                std::string_view& key, std::string_view& value,
+                                std::size_t& offset) {
+      std::string::size_type eq_loc = arg.find('=');
+      Conversion converted          = Conversion::OK;
+      std::int64_t integer;
+      double real;
+
+      key    = std::string_view(arg).substr(0, eq_loc);
+      value  = std::string_view();
+      offset = 0;
+
+      if (key.empty()) {
+        return Error_Code::BAD_FORMAT;
+      }
+
+      if (opt.key_type == Property::Arg_Type::INTEGER) {
+        converted = to_integer(key, integer);
+      }
+      else if (opt.key_type == Property::Arg_Type::FLOAT) {
+        converted = to_float(key, real);
+      }
+
+      if (converted != Conversion::OK) {
+        return from_conversion(converted);
+      }
+
+      if (eq_loc == std::string::npos) {
+        offset = arg.size();
+
+        if (opt.type == Property::Arg_Type::STRING && opt.choices.empty()) {
+          return Error_Code::NONE;
+        }
+
+        return Error_Code::BAD_FORMAT;
+      }
+
+      value  = std::string_view(arg).substr(eq_loc + 1);
+      offset = eq_loc + 1;
+
+      return verify_arg_type(arg.substr(eq_loc + 1), opt);
     }
   }
 
-  Command::Command(): is_case_sensitive(true),
+  const char * describe(Error_Code code) noexcept {
+    switch (code) {
+    case Error_Code::NONE:
+      return "no error";
+    case Error_Code::COMMAND_NOT_FOUND:
+      return "command not found";
+    case Error_Code::UNKNOWN_COMMAND:
+      return "argument does not match any command";
+    case Error_Code::INVALID_PREFIX:
+      return "invalid prefix";
+    case Error_Code::SPECIAL_PREFIX:
+      return "bsd-style option used a prefix";
+    case Error_Code::SPECIAL_MIXED:
+      return "only some characters of a merged option are options";
+    case Error_Code::SPECIAL_ASSIGN:
+      return "bsd or merged option given an argument";
+    case Error_Code::UNKNOWN_OPTION:
+      return "unknown option";
+    case Error_Code::REPEATED:
+      return "option repeated more than allowed";
+    case Error_Code::UNEXPECTED_ARGUMENT:
+      return "option does not take an argument this way";
+    case Error_Code::MISSING_EQUALS:
+      return "option is missing equals sign";
+    case Error_Code::MISSING_ARGUMENT:
+      return "option is missing an argument";
+    case Error_Code::BAD_FORMAT:
+      return "data does not match its declared type";
+    case Error_Code::OUT_OF_RANGE:
+      return "data is out of range for its declared type";
+    case Error_Code::NOT_IN_RANGE:
+      return "data is outside the declared range";
+    case Error_Code::NOT_A_CHOICE:
+      return "data is not one of the declared choices";
+    case Error_Code::AMBIGUOUS_OPTION:
+      return "abbreviation matches several options";
+    case Error_Code::DUPLICATE_KEY:
+      return "map option given the same key twice";
+    case Error_Code::MISSING_REQUIRED:
+      return "required option not given";
+    case Error_Code::MISSING_DEPENDENCY:
+      return "option given without an option it depends on";
+    case Error_Code::CONFLICTING_OPTIONS:
+      return "options that exclude each other given together";
+    }
+
+    return "unknown error";
+  }
+
+  Command::Command(): name(std::string("")),
+                      first_id(0),
+                      is_case_sensitive(true),
                       is_bsd_opt_enabled(false),
                       is_merged_opt_enabled(false),
                       is_error_unknown_enabled(true),
-                      name(std::string("")) {}
+                      is_abbrev_enabled(false),
+                      revision(0) {}
 
-  Command::Command(const std::string& name): is_case_sensitive(true),
+  Command::Command(const std::string& name): name(name),
+                                             first_id(0),
+                                             is_case_sensitive(true),
                                              is_bsd_opt_enabled(false),
                                              is_merged_opt_enabled(false),
                                              is_error_unknown_enabled(true),
-                                             name(name) {}
+                                             is_abbrev_enabled(false),
+                                             revision(0) {}
+
+  Command::Command(std::shared_ptr<const Command> base, const std::string& name):
+      name(name),
+      first_id(base->id_count()),
+      is_case_sensitive(base->is_case_sensitive),
+      is_bsd_opt_enabled(base->is_bsd_opt_enabled),
+      is_merged_opt_enabled(base->is_merged_opt_enabled),
+      is_error_unknown_enabled(base->is_error_unknown_enabled),
+      is_abbrev_enabled(base->is_abbrev_enabled),
+      revision(0) {
+    base->shared.is_set.store(true, std::memory_order_relaxed);
+    this->base = std::move(base);
+  }
 
   bool Command::empty() const noexcept {
-    return this->handles.empty();
+    return this->handles.empty() && (!this->base || this->base->empty());
+  }
+
+  // a shared base is read by its overlays in place, so it may not change
+  void Command::check_unshared() const {
+    if (this->shared.is_set.load(std::memory_order_relaxed)) {
+      throw command_error("cannot change a Command shared as a base");
+    }
   }
 
   void Command::clear() {
+    check_unshared();
+    this->revision = next_revision();
+    this->base.reset();
+    this->first_id = 0;
     this->handles.clear();
     this->commands.clear();
+    this->ids.clear();
+    this->names.clear();
+    this->handle_index.clear();
+    this->handle_prefixes.clear();
+    this->command_prefixes.clear();
+    this->patterns.clear();
+    this->rules.clear();
+    this->env_names    = Flat_Map();
+    this->config_names = Flat_Map();
+    this->bound.clear();
   }
 
-  std::shared_ptr<Command> Command::command(const std::string& spec) {
-    if (spec == std::string("")) {
-      throw command_error("subcommand may not be named after the empty string");
-    }
-    else {
-      auto cmd = std::make_shared<Command>(spec);
+  void Command::required(const std::string& name) {
+    add_rule(Rule_Kind::REQUIRED, nullptr, { name });
+  }
 
-      commands.insert(std::make_pair(spec, cmd));
+  void Command::depends(const std::string& name, const std::vector<std::string>& others) {
+    add_rule(Rule_Kind::DEPENDS, &name, others);
+  }
 
-      return cmd;
-    }
+  void Command::conflicts(const std::string& name, const std::vector<std::string>& others) {
+    add_rule(Rule_Kind::CONFLICTS, &name, others);
   }
 
-  std::shared_ptr<Option> Command::option(const std::string& spec, const std::string& name) {
-    enum class Option_State {
-      HANDLES, EQ, ARG,
-      ARGLIST, ARGLIST_END, DONE,
-      NAME, PREFIX_END, PLUS_PREFIX,
-      MINUS_PREFIX, NUMBER
+  void Command::at_least_one(const std::vector<std::string>& group) {
+    add_rule(Rule_Kind::AT_LEAST_ONE, nullptr, group);
+  }
+
+  void Command::exactly_one(const std::vector<std::string>& group) {
+    add_rule(Rule_Kind::EXACTLY_ONE, nullptr, group);
+  }
+
+  void Command::add_rule(Rule_Kind kind, const std::string * subject,
+                         const std::vector<std::string>& group) {
+    auto id_of = [this](const std::string& name) {
+      int id = find_id(name);
+
+      if (id < 0) {
+        throw option_language_error(std::string("constraint names an undeclared option: ")
+                                    + name);
+      }
+
+      return id;
     };
 
-    Option_State state = Option_State::HANDLES;
-    auto opt = std::make_shared<Option>();
-    std::vector<std::string> handle_vec;
-    int index = 0;
-    std::ostringstream buf;
+    if (group.empty()) {
+      throw option_language_error(std::string("constraint needs at least one option"));
+    }
 
-    /* 
-     * this loop processes the spec and name into an Option object,
-     * which is returned at the end of the switch case/DONE
-     */
-    while (true) {
-      switch(state) {
-      case Option_State::HANDLES:
-        if (index >= spec.size()) {
-          state = Option_State::DONE;
-        }
+    this->revision = next_revision();
 
-        switch (spec[index]) {
-        case '/':
-        case '.':
-        case ':':
-          state = Option_State::PREFIX_END;
+    Rule rule{ kind, (subject ? id_of(*subject) : -1), {} };
 
-          break;
-        case '+':
-          state = Option_State::PLUS_PREFIX;
+    for (const auto& name : group) {
+      std::size_t id = id_of(name);
 
-          break;
-        case '-':
-          state = Option_State::MINUS_PREFIX;
+      if (rule.group.size() <= id / 64) {
+        rule.group.resize(id / 64 + 1);
+      }
 
-          break;
-        default:
-          if (is_name_start_char(spec[index])) {
-            state = Option_State::NAME;
-          }
-          else {
-            throw option_language_error(std::string("expected prefix or word character"));
-          }
+      rule.group[id / 64] |= std::uint64_t(1) << (id % 64);
+    }
 
-          break;
-        }
+    this->rules.push_back(std::move(rule));
+  }
 
-        buf << (spec[index]);
+  /*
+   * report a problem with argv[at], or with the value of an option
+   * from another source. without diags this throws; otherwise the
+   * problem is recorded and parsing goes on. the message is only built
+   * when it will be thrown. source, if any, begins the message
+   */
+  struct Command::Reporter {
+    Diagnostics * diags;
+    int base;
+    std::string source;
+
+    template <typename Message>
+    void operator()(Error_Code code, int at, std::size_t offset,
+                    const Option * culprit, Message&& message) const {
+      CMDPARSE_PROBE3(error, static_cast<int>(code), base + at, (culprit ? culprit->id : -1));
+
+      if (diags == nullptr) {
+        throw parse_error(code, source + message());
+      }
 
-        break;
-      case Option_State::MINUS_PREFIX:
-        if (index >= spec.size()) {
-          throw option_language_error(std::string("input ended before handle complete"));
-        }
+      diags->push_back(Diagnostic{code, static_cast<std::uint32_t>(offset),
+                                  base + at, (culprit ? culprit->id : -1)});
+    }
+  };
 
-        if (spec[index] == '-') {
-          state = Option_State::PREFIX_END;
-        }
-        else if (is_name_start_char(spec[index])) {
-          state = Option_State::NAME;
-        }
-        else {
-          throw option_language_error(std::string("input ended before handle complete"));
+  void Command::Presence::mark(const Option& opt, int at) {
+    if (this->present.empty()) {
+      return;
+    }
+
+    std::uint64_t bit = std::uint64_t(1) << (opt.id % 64);
+
+    if (opt.negated) {
+      this->present[opt.id / 64] &= ~bit;
+      this->seen[opt.id] = -1;
+    }
+    else if (this->seen[opt.id] < 0) {
+      this->present[opt.id / 64] |= bit;
+      this->seen[opt.id] = at;
+    }
+  }
+
+  /*
+   * present has a bit for each option found by the parse, and seen the
+   * index of its first use or -1. end is the index reported for an
+   * option that is missing. each rule costs a few word operations per
+   * 64 ids its group spans
+   */
+  void Command::check_rules(const Presence& found, int end, Diagnostics * diags) const {
+    const Id_Set& present        = found.present;
+    const std::vector<int>& seen = found.seen;
+
+    auto list = [this](const Id_Set& group) {
+      std::string msg;
+
+      for (std::size_t id = 0; id < group.size() * 64; ++id) {
+        if (group[id / 64] & (std::uint64_t(1) << (id % 64))) {
+          msg += (msg.empty() ? "'" : ", '") + option_name(id) + "'";
         }
+      }
 
-        buf << (spec[index]);
+      return msg;
+    };
 
-        break;
-      case Option_State::PLUS_PREFIX:
-        if (index >= spec.size()) {
-          throw option_language_error(std::string("input ended before handle complete"));
+    for (const Rule& rule : this->rules) {
+      std::size_t found = 0;
+      bool missing      = false;
+      int first = -1, second = -1; // ids found in the group, by first use
+
+      for (std::size_t w = 0; w < rule.group.size(); ++w) {
+        std::uint64_t hits = rule.group[w] & present[w];
+
+        found   += std::bitset<64>(hits).count();
+        missing |= (hits != rule.group[w]);
+
+        // only a conflict needs to know which options were found
+        for (; hits != 0 && (rule.kind == Rule_Kind::CONFLICTS
+                             || rule.kind == Rule_Kind::EXACTLY_ONE); hits &= hits - 1) {
+          int id = w * 64 + std::bitset<64>((hits & -hits) - 1).count();
+
+          if (first < 0 || seen[id] < seen[first]) {
+            second = first;
+            first  = id;
+          }
+          else if (second < 0 || seen[id] < seen[second]) {
+            second = id;
+          }
         }
+      }
 
-        if (spec[index] == '+') {
-          state = Option_State::PREFIX_END;
+      bool has_subject = rule.subject >= 0
+          && (present[rule.subject / 64] & (std::uint64_t(1) << (rule.subject % 64)));
+
+      Error_Code code = Error_Code::NONE;
+      int at = end, culprit = rule.subject;
+      std::string msg;
+
+      switch (rule.kind) {
+      case Rule_Kind::REQUIRED:
+      case Rule_Kind::AT_LEAST_ONE:
+        if (found == 0) {
+          code = Error_Code::MISSING_REQUIRED;
+          msg  = (rule.kind == Rule_Kind::REQUIRED) ? "missing required option "
+                                                    : "one of these options is required: ";
+          msg += list(rule.group);
         }
-        else if (is_name_start_char(spec[index])) {
-          state = Option_State::NAME;
+        break;
+      case Rule_Kind::DEPENDS:
+        if (has_subject && missing) {
+          code = Error_Code::MISSING_DEPENDENCY;
+          at   = seen[rule.subject];
+          msg  = "option '" + option_name(rule.subject) + "' must be given with "
+               + list(rule.group);
         }
-        else {
-          throw option_language_error(std::string("input ended before handle complete"));
+        break;
+      case Rule_Kind::CONFLICTS:
+        if (has_subject && found > 0) {
+          code = Error_Code::CONFLICTING_OPTIONS;
+          at   = std::max(seen[rule.subject], seen[first]);
+          msg  = "option '" + option_name(rule.subject) + "' may not be given with "
+               + list(rule.group);
         }
-
         break;
-      case Option_State::PREFIX_END:
-        if (index >= spec.size()) {
-          throw option_language_error(std::string("input ended before handle complete"));
+      case Rule_Kind::EXACTLY_ONE:
+        if (found != 1) {
+          code    = (found == 0) ? Error_Code::MISSING_REQUIRED
+                                 : Error_Code::CONFLICTING_OPTIONS;
+          at      = (found == 0) ? end : seen[second];
+          culprit = (found == 0) ? -1 : second;
+          msg     = "exactly one of these options is required: " + list(rule.group);
         }
+        break;
+      }
 
-        if (is_name_start_char(spec[index])) {
-          buf << (spec[index]);
+      if (code == Error_Code::NONE) {
+        continue;
+      }
+
+      if (diags == nullptr) {
+        throw parse_error(code, std::move(msg));
+      }
+
+      diags->push_back(Diagnostic{code, 0, at, culprit});
+    }
+  }
+
+  std::size_t Command::declare_registered() {
+    std::vector<Option_Spec> pending;
+
+    for (auto reg = Registration::first(); reg != nullptr; reg = reg->next()) {
+      pending.push_back(Option_Spec{ reg->spec, reg->name });
+    }
+
+    // the list is newest first
+    std::reverse(pending.begin(), pending.end());
+
+    return options(pending);
+  }
+
+  std::size_t Command::options(std::initializer_list<Option_Spec> specs) {
+    return options(specs.begin(), specs.size());
+  }
+
+  std::size_t Command::options(const std::vector<Option_Spec>& specs) {
+    return options(specs.data(), specs.size());
+  }
+
+  std::size_t Command::options(const Option_Spec * specs, std::size_t count) {
+    check_unshared();
+
+    std::vector<std::pair<std::shared_ptr<Option>, Handle_List>> compiled(count);
+    std::vector<handle_map_t::iterator> added;
+    std::size_t total  = 0;
+    std::size_t failed = 0;
+    std::string errors;
+
+    auto reject = [&](std::size_t i, const std::string& message) {
+      ++failed;
+      errors += "\n  spec " + std::to_string(i) + " '" + specs[i].spec + "': " + message;
+    };
+
+    for (std::size_t i = 0; i < count; ++i) {
+      try {
+        compiled[i].first = compile(specs[i].spec, specs[i].name, compiled[i].second);
+        total += compiled[i].second.size();
+      }
+      catch (option_language_error& e) {
+        reject(i, e.what());
+      }
+    }
+
+    // with room reserved, no insert rehashes, so added stays valid
+    this->handles.reserve(this->handles.size() + total);
+    added.reserve(total);
+
+    // the insert that fills the table also finds repeated handles
+    for (std::size_t i = 0; i < count; ++i) {
+      if (!compiled[i].first) {
+        continue;
+      }
+
+      for (const auto& handle : compiled[i].second) {
+        auto result = this->handles.insert(handle);
+
+        if (!result.second) {
+          reject(i, "handle repeated: " + handle.first);
+          break;
+        }
+
+        added.push_back(result.first);
+      }
+    }
+
+    if (failed > 0) {
+      for (auto iter : added) {
+        this->handles.erase(iter);
+      }
+
+      throw option_language_error(std::to_string(failed) + " of " + std::to_string(count)
+                                  + " option specs rejected:" + errors);
+    }
+
+    std::vector<std::string> keys;
+
+    this->revision = next_revision();
+    this->ids.reserve(this->ids.size() + count);
+    this->names.reserve(this->names.size() + count);
+    keys.reserve(total);
+
+    for (const auto& entry : compiled) {
+      install(entry.first, entry.second, false);
+    }
+
+    for (auto iter : added) {
+      keys.push_back(iter->first);
+    }
+
+    this->handle_index.insert(keys);
+    this->handle_prefixes.insert(std::move(keys));
+
+    return count;
+  }
+
+  std::shared_ptr<Command> Command::command(const std::string& spec) {
+    if (spec == std::string("")) {
+      throw command_error("subcommand may not be named after the empty string");
+    }
+    else {
+      auto cmd = std::make_shared<Command>(spec);
+
+      this->revision = next_revision();
+
+      commands.insert(std::make_pair(spec, cmd));
+      command_prefixes.insert(spec);
+
+      return cmd;
+    }
+  }
+
+  std::shared_ptr<Option> Command::option(const std::string& spec, const std::string& name) {
+    check_unshared();
+
+    Handle_List new_handles;
+    auto opt = compile(spec, name, new_handles);
+
+    this->revision = next_revision();
+    install(opt, new_handles, true);
+
+    return opt;
+  }
+
+  /*
+   * add the handles of a compiled option to every table. a batch has
+   * put its handles in the handle map already, and fills the indexes
+   * of handles at once afterward
+   */
+  void Command::install(const std::shared_ptr<Option>& opt, const Handle_List& new_handles,
+                        bool one_by_one) {
+    // insert handles known with the option
+    for (const auto& handle : new_handles) {
+      if (one_by_one) {
+        if (!this->handles.insert(handle).second) {
+          throw option_language_error(std::string("handle repeated: ") + handle.first);
+        }
+
+        this->handle_index.insert(handle.first);
+        this->handle_prefixes.insert(handle.first);
+      }
+
+      if (handle.second->assignment == Property::Assignment::STUCK
+          || handle.second->assignment == Property::Assignment::PREFIX) {
+        this->patterns.insert(handle.first);
+      }
+    }
+
+    // options sharing a name share an id
+    int id = find_id(opt->name);
+
+    if (id < 0) {
+      opt->id = id_count();
+      this->ids.insert(std::make_pair(opt->name, opt->id));
+      this->names.push_back(opt->name);
+    }
+    else {
+      opt->id = id;
+    }
+
+    for (const auto& handle : new_handles) {
+      handle.second->id = opt->id;
+    }
+  }
+
+  /*
+   * read a spec into an Option and the handles that lead to it,
+   * without changing the Command
+   */
+  std::shared_ptr<Option> Command::compile(const std::string& spec, const std::string& name,
+                                           Handle_List& new_handles) {
+    enum class Option_State {
+      HANDLES, EQ, ARG,
+      ARGLIST, ARGLIST_END, DONE,
+      NAME, PREFIX_END, PLUS_PREFIX,
+      MINUS_PREFIX, NUMBER, CONSTRAINT,
+      ARGLIST_CONSTRAINT
+    };
+
+    Option_State state = Option_State::HANDLES;
+    auto opt = std::make_shared<Option>();
+    std::vector<std::string> handle_vec;
+    bool negatable = false;
+    int index = 0;
+    std::string buf;
+
+    /* 
+     * this loop processes the spec and name into an Option object,
+     * which is returned at the end of the switch case/DONE
+     */
+    while (true) {
+      switch(state) {
+      case Option_State::HANDLES:
+        if (index >= spec.size()) {
+          state = Option_State::DONE;
+        }
+
+        switch (spec[index]) {
+        case '/':
+        case '.':
+        case ':':
+          state = Option_State::PREFIX_END;
+
+          break;
+        case '+':
+          state = Option_State::PLUS_PREFIX;
+
+          break;
+        case '-':
+          state = Option_State::MINUS_PREFIX;
+
+          break;
+        default:
+          if (is_name_start_char(spec[index])) {
+            state = Option_State::NAME;
+          }
+          else {
+            throw option_language_error(std::string("expected prefix or word character"));
+          }
+
+          break;
+        }
+
+        buf += spec[index];
+
+        break;
+      case Option_State::MINUS_PREFIX:
+        if (index >= spec.size()) {
+          throw option_language_error(std::string("input ended before handle complete"));
+        }
+
+        if (spec[index] == '-') {
+          state = Option_State::PREFIX_END;
+        }
+        else if (is_name_start_char(spec[index])) {
+          state = Option_State::NAME;
+        }
+        else {
+          throw option_language_error(std::string("input ended before handle complete"));
+        }
+
+        buf += spec[index];
+
+        break;
+      case Option_State::PLUS_PREFIX:
+        if (index >= spec.size()) {
+          throw option_language_error(std::string("input ended before handle complete"));
+        }
+
+        if (spec[index] == '+') {
+          state = Option_State::PREFIX_END;
+        }
+        else if (is_name_start_char(spec[index])) {
+          state = Option_State::NAME;
+        }
+        else {
+          throw option_language_error(std::string("input ended before handle complete"));
+        }
+
+        break;
+      case Option_State::PREFIX_END:
+        if (index >= spec.size()) {
+          throw option_language_error(std::string("input ended before handle complete"));
+        }
+
+        if (is_name_start_char(spec[index])) {
+          buf += spec[index];
 
           state = Option_State::NAME;
         }
@@ -335,9 +1051,9 @@ namespace cli {
         break;
       case Option_State::NAME:
         if (index >= spec.size()) {
-          if (!buf.str().empty()) {
-            handle_vec.push_back(buf.str());
-            buf.str("");
+          if (!buf.empty()) {
+            handle_vec.push_back(buf);
+            buf.clear();
           }
 
           state = Option_State::DONE;
@@ -346,14 +1062,14 @@ namespace cli {
 
         switch (spec[index]) {
         case '|':
-          handle_vec.push_back(buf.str());
-          buf.str("");
+          handle_vec.push_back(buf);
+          buf.clear();
 
           state = Option_State::HANDLES;
           break;
         case '=':
-          handle_vec.push_back(buf.str());
-          buf.str("");
+          handle_vec.push_back(buf);
+          buf.clear();
 
           opt->assignment = Property::Assignment::EQ_REQUIRED;
           opt->collection = Property::Collection::SCALAR;
@@ -361,24 +1077,31 @@ namespace cli {
           state = Option_State::EQ;
           break;
         case '?':
-          handle_vec.push_back(buf.str());
-          buf.str("");
+          handle_vec.push_back(buf);
+          buf.clear();
     
           state = Option_State::NUMBER;
     
           opt->number = Property::Number::ZERO_ONE;
           break;
         case '*':
-          handle_vec.push_back(buf.str());
-          buf.str("");
+          handle_vec.push_back(buf);
+          buf.clear();
 
           state = Option_State::NUMBER;
 
           opt->number = Property::Number::ZERO_MANY;
           break;
+        case '!':
+          handle_vec.push_back(buf);
+          buf.clear();
+
+          negatable = true;
+          state     = Option_State::DONE;
+          break;
         default:
           if (is_name_rest_char(spec[index])) {
-            buf << (spec[index]);
+            buf += spec[index];
           }
           else {
             throw option_language_error(std::string("invalid character for handle name: can only take word characters and '-'"));
@@ -393,9 +1116,6 @@ namespace cli {
           break;
         }
 
-        handle_vec.push_back(buf.str());
-        buf.str("");
-
         if (spec[index] == '=') {
           opt->assignment = Property::Assignment::EQ_REQUIRED;
           opt->collection = Property::Collection::SCALAR;
@@ -424,6 +1144,11 @@ namespace cli {
             opt->assignment = Property::Assignment::STUCK;
             state = Option_State::ARG;
 
+            break;
+          case '&':
+            opt->assignment = Property::Assignment::PREFIX;
+            state = Option_State::ARG;
+
             break;
           case '?':
             opt->assignment = Property::Assignment::EQ_MAYBE;
@@ -441,19 +1166,32 @@ namespace cli {
             opt->assignment = Property::Assignment::EQ_REQUIRED;
 
             break;
+          case '{': {
+            std::string::size_type close = read_map(spec, index, *opt);
+
+            if (close == std::string::npos) {
+              opt->type = Property::Arg_Type::STRING;
+              close = read_constraint(spec, index, *opt);
+            }
+
+            index = close;
+            state = Option_State::DONE;
+
+            break;
+          }
           case 's':
             opt->type = Property::Arg_Type::STRING;
-            state = Option_State::DONE;
+            state = Option_State::CONSTRAINT;
 
             break;
           case 'i':
             opt->type = Property::Arg_Type::INTEGER;
-            state = Option_State::DONE;
+            state = Option_State::CONSTRAINT;
 
             break;
           case 'f':
             opt->type = Property::Arg_Type::FLOAT;
-            state = Option_State::DONE;
+            state = Option_State::CONSTRAINT;
 
             break;
           default:
@@ -477,19 +1215,32 @@ namespace cli {
             opt->collection = Property::Collection::LIST;
 
             break;
+          case '{': {
+            std::string::size_type close = read_map(spec, index, *opt);
+
+            if (close == std::string::npos) {
+              opt->type = Property::Arg_Type::STRING;
+              close = read_constraint(spec, index, *opt);
+            }
+
+            index = close;
+            state = Option_State::DONE;
+
+            break;
+          }
           case 's':
             opt->type = Property::Arg_Type::STRING;
-            state = Option_State::DONE;
+            state = Option_State::CONSTRAINT;
 
             break;
           case 'i':
             opt->type = Property::Arg_Type::INTEGER;
-            state = Option_State::DONE;
+            state = Option_State::CONSTRAINT;
 
             break;
           case 'f':
             opt->type = Property::Arg_Type::FLOAT;
-            state = Option_State::DONE;
+            state = Option_State::CONSTRAINT;
 
             break;
           default:
@@ -508,17 +1259,17 @@ namespace cli {
         switch (spec[index]) {
           case 's':
             opt->type = Property::Arg_Type::STRING;
-            state = Option_State::ARGLIST_END;
+            state = Option_State::ARGLIST_CONSTRAINT;
 
             break;
           case 'i':
             opt->type = Property::Arg_Type::INTEGER;
-            state = Option_State::ARGLIST_END;
+            state = Option_State::ARGLIST_CONSTRAINT;
 
             break;
           case 'f':
             opt->type = Property::Arg_Type::FLOAT;
-            state = Option_State::ARGLIST_END;
+            state = Option_State::ARGLIST_CONSTRAINT;
 
             break;
           case ']':
@@ -547,6 +1298,41 @@ namespace cli {
                       "expected ']' to conclude arg list"));
         }
 
+        break;
+      case Option_State::ARGLIST_CONSTRAINT:
+        if (index >= spec.size()) {
+          throw option_language_error(std::string(
+                      "input ended before arg list finished"));
+        }
+
+        if (spec[index] == ']') {
+          state = Option_State::DONE;
+        }
+        else if (spec[index] == '{') {
+          index = read_constraint(spec, index, *opt);
+          state = Option_State::ARGLIST_END;
+        }
+        else {
+          throw option_language_error(std::string(
+                      "expected constraint or ']' to conclude arg list"));
+        }
+
+        break;
+      case Option_State::CONSTRAINT:
+        if (index >= spec.size()) {
+          state = Option_State::DONE;
+          break;
+        }
+
+        if (spec[index] == '{') {
+          index = read_constraint(spec, index, *opt);
+          state = Option_State::DONE;
+        }
+        else {
+          throw option_language_error(std::string(
+                      "expected constraint or end of option spec"));
+        }
+
         break;
       case Option_State::DONE:
         if (index < spec.size()) {
@@ -571,7 +1357,7 @@ namespace cli {
               ind = 2;
             }
           
-            if (maybe_name.size() == ind + 1) { // NOTE: this situation should never happen
+            if (maybe_name.size() == ind) { // NOTE: this situation should never happen
               throw option_language_error(std::string("handle minus prefix is the empty string"));
             }
             else {
@@ -598,15 +1384,41 @@ namespace cli {
             }
           }
 
-            // insert handles known with the option
-            for (const std::string handle : handle_vec) {
-              if (this->handles.find(handle) == this->handles.cend()) {
-                this->handles.insert(std::make_pair(handle, opt));
+          // a prefix handle would otherwise take every word as its own
+          if (opt->assignment == Property::Assignment::PREFIX) {
+            for (const std::string& handle : handle_vec) {
+              if (skip_prefix(handle) <= 0) {
+                throw option_language_error(std::string("option declared ")
+                    + "with PREFIX assignment must have prefixed handles");
               }
-              else {
-                throw option_language_error(std::string("handle repeated: ") + handle);
+            }
+          }
+
+          /*
+           * a flag declared with '!' is also cleared by its long handles
+           * with "no-" after the prefix; those share the name but not
+           * the Option
+           */
+          for (const std::string& handle : handle_vec) {
+            new_handles.push_back(std::make_pair(handle, opt));
+          }
+
+          if (negatable) {
+            auto negation = std::make_shared<Option>();
+
+            negation->name    = opt->name;
+            negation->number  = Property::Number::ZERO_MANY;
+            negation->negated = true;
+
+            for (const std::string& handle : handle_vec) {
+              int prefix_size = std::max(skip_prefix(handle), 0);
+
+              if (handle.size() - prefix_size > 1) {
+                new_handles.push_back(std::make_pair(handle.substr(0, prefix_size)
+                    + "no-" + handle.substr(prefix_size), negation));
               }
             }
+          }
         }
 
         return opt;
@@ -621,59 +1433,621 @@ namespace cli {
     }
   }
     
+  // argv is left as given; parse works on a copy of the array
   Info Command::parse(char ** argv, int argc, Info * d) const {
-    Info info;
-    Info * infop = (d == nullptr) ? &info : d;
-    std::shared_ptr<Option> opt;
-    std::string args("");
-    int index = 0;
+    return parse(static_cast<const char * const *>(argv), argc, d);
+  }
 
-    if (index > argc - 1) {
-      return *infop;
-    }
+  Info Command::parse(char ** argv, int argc, Diagnostics& diags, Info * d) const {
+    return parse(static_cast<const char * const *>(argv), argc, diags, d);
+  }
 
-    // try to get this command's name unless it is empty string
-    if (!this->name.empty()) {
-      if (this->name == argv[index]) {
-        argv[index++] = (char*)"";
-        infop->commands.insert(this->name);
-      }
-      else {
-        throw parse_error(std::string("command not found"));
+  void Command::bind_env(const std::string& name, const std::string& variable) {
+    this->env_names.assign(variable, name);
+    this->bound[name] = bindable(name);
+    this->revision = next_revision();
+  }
+
+  void Command::bind_key(const std::string& name, const std::string& key) {
+    this->config_names.assign(key, name);
+    this->bound[name] = bindable(name);
+    this->revision = next_revision();
+  }
+
+  std::shared_ptr<Option> Command::bindable(const std::string& name) const {
+    for (const auto& handle : this->handles) {
+      if (handle.second->name == name && !handle.second->negated) {
+        return handle.second;
       }
     }
 
-    /* BLOCK: delegate to command if this command owns any */
-    if (!commands.empty()) {
-      auto cmd_iter = commands.find(argv[index]);
-      if (cmd_iter == commands.cend()) {
-        throw parse_error(std::string("initial argument does not match any command"));
-      }
-      else {
-        cmd_iter->second->parse(argv + index, argc - index, infop);
-      }
+    if (this->base) {
+      return this->base->bindable(name);
     }
 
+    throw option_language_error(std::string("cannot bind undeclared option: ") + name);
+  }
+
+  Info Command::parse_sources(char ** argv, int argc, const std::string& config,
+                              Info * d) const {
+    if (d != nullptr) {
+      parse_sources_into(argv, argc, config, d, nullptr);
+
+      return *d;
+    }
+
+    Info info;
+
+    parse_sources_into(argv, argc, config, &info, nullptr);
+
+    return info;
+  }
+
+  Info Command::parse_sources(char ** argv, int argc, const std::string& config,
+                              Diagnostics& diags, Info * d) const {
+    if (d != nullptr) {
+      parse_sources_into(argv, argc, config, d, &diags);
+
+      return *d;
+    }
+
+    Info info;
+
+    parse_sources_into(argv, argc, config, &info, &diags);
+
+    return info;
+  }
+
+  /*
+   * argv is parsed first, then the environment, then the config file.
+   * an option found in one source is skipped in those after it, so argv
+   * wins over the environment and both win over the file. within the
+   * file, a later line replaces a scalar and adds to a list or map
+   */
+  void Command::parse_sources_into(char ** argv, int argc, const std::string& config,
+                                   Info * infop, Diagnostics * diags) const {
+    Presence presence;
+    std::unordered_set<const Option *> from_config;
+
+    if (!this->rules.empty()) {
+      presence.present.resize(id_count() / 64 + 1);
+      presence.seen.resize(id_count(), -1);
+    }
+
+    // like parse, argv is left as given
+    std::vector<char *> words(argv, argv + std::max(argc, 0));
+
+    parse_into(words.data(), argc, infop, diags, 0, nullptr, &presence);
+
+    // a flag is set by a true value and left unset by a false one
+    auto apply = [&](const Option& opt, std::string_view value, std::size_t offset,
+                     const Reporter& fail) {
+      if (opt.assignment != Property::Assignment::NO_ASSIGN) {
+        // a rejected value stores nothing and gives the option no presence
+        if (!store(opt, std::string(value), 0, offset, infop, fail)) {
+          return;
+        }
+      }
+      else if (value == "1" || value == "true" || value == "yes" || value == "on") {
+        infop->data.insert(std::make_pair(opt.name, std::string("")));
+      }
+      else {
+        if (!(value.empty() || value == "0" || value == "false" || value == "no"
+              || value == "off")) {
+          fail(Error_Code::BAD_FORMAT, 0, offset, &opt,
+              [&] { return std::string("flag '") + opt.name + "' takes a boolean, not '"
+                            + std::string(value) + "'"; });
+        }
+
+        return;
+      }
+
+      presence.mark(opt, argc);
+    };
+
+    if (!this->env_names.empty()) {
+      for (char ** entry = environ; *entry != nullptr; ++entry) {
+        std::string_view word(*entry);
+        std::size_t eq = word.find('=');
+        const std::string * name;
+
+        if (eq == std::string_view::npos
+            || (name = this->env_names.find(word.substr(0, eq))) == nullptr) {
+          continue;
+        }
+
+        const Option& opt = *this->bound.at(*name);
+
+        if (!infop->has(opt.name)) {
+          apply(opt, word.substr(eq + 1), 0,
+                Reporter{ diags, -1, "environment variable "
+                                     + std::string(word.substr(0, eq)) + ": " });
+        }
+      }
+    }
+
+    if (!config.empty()) {
+      int fd = open(config.c_str(), O_RDONLY);
+
+      if (fd < 0) {
+        if (errno != ENOENT) {
+          throw std::system_error(errno, std::generic_category(), config);
+        }
+      }
+      else {
+        struct stat status;
+        void * mapped = MAP_FAILED;
+
+        if (fstat(fd, &status) == 0 && status.st_size > 0) {
+          mapped = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+
+        close(fd);
+
+        if (mapped != MAP_FAILED) {
+          std::string_view text(static_cast<const char *>(mapped), status.st_size);
+
+          try {
+            read_config(text, config, infop, diags, from_config, apply);
+          }
+          catch (...) {
+            munmap(mapped, status.st_size);
+            throw;
+          }
+
+          munmap(mapped, status.st_size);
+        }
+      }
+    }
+
+    if (!this->rules.empty()) {
+      check_rules(presence, argc, diags);
+    }
+  }
+
+  /*
+   * lines of "key = value"; blank lines and lines beginning with '#'
+   * are skipped, and space around the key and the value is dropped.
+   * the text is read where it lies; only the values kept are copied
+   */
+  template <typename Apply>
+  void Command::read_config(std::string_view text, const std::string& path, Info * infop,
+                            Diagnostics * diags, std::unordered_set<const Option *>& seen,
+                            Apply&& apply) const {
+    auto trim = [](std::string_view str, std::size_t& at) {
+      while (!str.empty() && std::isspace(static_cast<unsigned char>(str.front()))) {
+        str.remove_prefix(1);
+        ++at;
+      }
+
+      while (!str.empty() && std::isspace(static_cast<unsigned char>(str.back()))) {
+        str.remove_suffix(1);
+      }
+
+      return str;
+    };
+
+    std::size_t begin = 0;
+    int line_number   = 0;
+
+    while (begin < text.size()) {
+      std::size_t end = text.find('\n', begin);
+
+      if (end == std::string_view::npos) {
+        end = text.size();
+      }
+
+      ++line_number;
+
+      std::size_t key_at = begin;
+      std::string_view line = trim(text.substr(begin, end - begin), key_at);
+
+      begin = end + 1;
+
+      if (line.empty() || line.front() == '#') {
+        continue;
+      }
+
+      Reporter fail{ diags, -1, path + ":" + std::to_string(line_number) + ": " };
+      std::size_t eq = line.find('=');
+
+      if (eq == std::string_view::npos) {
+        fail(Error_Code::MISSING_EQUALS, 0, key_at + line.size(), nullptr,
+            [] { return std::string("expected key = value"); });
+        continue;
+      }
+
+      std::size_t value_at = key_at + eq + 1;
+      std::size_t ignored  = 0;
+      std::string_view key = trim(line.substr(0, eq), ignored);
+      std::string_view value = trim(line.substr(eq + 1), value_at);
+      const std::string * name = this->config_names.find(key);
+
+      if (name == nullptr) {
+        if (this->is_error_unknown_enabled) {
+          fail(Error_Code::UNKNOWN_OPTION, 0, key_at, nullptr,
+              [&] { return std::string("unknown key: ") + std::string(key); });
+        }
+
+        continue;
+      }
+
+      const Option& opt = *this->bound.at(*name);
+
+      if (infop->has(opt.name) && seen.count(&opt) == 0) {
+        continue;
+      }
+
+      if (opt.collection == Property::Collection::SCALAR) {
+        infop->forget(opt.name);
+      }
+
+      seen.insert(&opt);
+      apply(opt, value, value_at, fail);
+    }
+  }
+
+  /*
+   * the parse only marks the copy of the array, never the strings.
+   * the result is returned by name, so it is not copied
+   */
+  Info Command::parse(const char * const * argv, int argc, Info * d) const {
+    std::vector<char *> words(std::max(argc, 0));
+
+    for (int i = 0; i < argc; ++i) {
+      words[i] = const_cast<char *>(argv[i]);
+    }
+
+    if (d != nullptr) {
+      parse_into(words.data(), argc, d, nullptr, 0, nullptr);
+
+      return *d;
+    }
+
+    Info info;
+
+    parse_into(words.data(), argc, &info, nullptr, 0, nullptr);
+
+    return info;
+  }
+
+  Info Command::parse(const char * const * argv, int argc, Diagnostics& diags,
+                      Info * d) const {
+    std::vector<char *> words(std::max(argc, 0));
+
+    for (int i = 0; i < argc; ++i) {
+      words[i] = const_cast<char *>(argv[i]);
+    }
+
+    if (d != nullptr) {
+      parse_into(words.data(), argc, d, &diags, 0, nullptr);
+
+      return *d;
+    }
+
+    Info info;
+
+    parse_into(words.data(), argc, &info, &diags, 0, nullptr);
+
+    return info;
+  }
+
+  int Command::permute(char ** argv, int argc, Info& info) const {
+    parse_into(argv, argc, &info, nullptr, 0, nullptr);
+
+    return compact(argv, argc);
+  }
+
+  int Command::permute(char ** argv, int argc, Info& info, Diagnostics& diags) const {
+    parse_into(argv, argc, &info, &diags, 0, nullptr);
+
+    return compact(argv, argc);
+  }
+
+  /*
+   * move the arguments left in argv to the front, keeping their order,
+   * and return their number. the consumed slots end up at the back
+   */
+  int Command::compact(char ** argv, int argc) {
+    int kept = 0;
+
+    for (int i = 0; i < argc; ++i) {
+      if (argv[i] != consumed_word) {
+        std::swap(argv[kept++], argv[i]);
+      }
+    }
+
+    return kept;
+  }
+
+  /*
+   * check the argument of an option and keep it in Info, taking a list
+   * apart at its commas. arg_index and arg_offset locate args for fail.
+   * returns whether any of it was kept
+   */
+  bool Command::store(const Option& opt, std::string args, int arg_index,
+                      std::size_t arg_offset, Info * infop, const Reporter& fail) {
+    if (opt.collection == Property::Collection::SCALAR
+        && opt.type == Property::Arg_Type::STRING) {
+      Error_Code result = verify_arg_type(args, opt);
+
+      if (result == Error_Code::NONE) {
+        infop->data.insert(std::make_pair(opt.name, args));
+        return true;
+      }
+
+      fail(result, arg_index, arg_offset, &opt,
+          [&] { return type_message(args, opt, result); });
+      return false;
+    }
+    else if (opt.collection == Property::Collection::MAP) {
+      std::string_view key, value;
+      std::size_t offset = 0;
+      Error_Code result  = verify_map_entry(args, opt, key, value, offset);
+
+      if (result != Error_Code::NONE) {
+        fail(result, arg_index, arg_offset + offset, &opt,
+            [&] { return type_message(args, opt, result); });
+        return false;
+      }
+
+      Flat_Map& map = infop->maps[opt.name];
+
+      switch (opt.duplicates) {
+      case Property::Duplicate_Key::LAST:
+        map.assign(key, value);
+        break;
+      case Property::Duplicate_Key::FIRST:
+        map.emplace(key, value);
+        break;
+      default:
+        if (!map.emplace(key, value)) {
+          fail(Error_Code::DUPLICATE_KEY, arg_index, arg_offset, &opt,
+              [&] { return std::string("key '") + std::string(key)
+                            + "' given more than once to option '"
+                            + opt.name + "'"; });
+          return false;
+        }
+        break;
+      }
+
+      return true;
+    }
+    else if (opt.type != Property::Arg_Type::STRING) {
+      /*
+       * numbers are kept converted in a typed vector, and as written for
+       * find and find_all by holding on to args. a scalar is one element
+       */
+      Info::Number_Text& text = infop->number_text[opt.name];
+      std::size_t kept = 0, rejected = 0;
+
+      auto convert = [&](auto& values) {
+        auto keep = [&](std::size_t begin, std::size_t end) {
+          std::string_view element(args.data() + begin, end - begin);
+          typename std::decay_t<decltype(values)>::value_type value;
+          Error_Code result = element.empty()
+                            ? Error_Code::BAD_FORMAT
+                            : convert_number(element, opt, value);
+
+          if (result == Error_Code::NONE) {
+            values.push_back(value);
+            text.push_back(begin, end);
+            ++kept;
+          }
+          else {
+            fail(result, arg_index, arg_offset + begin, &opt,
+                [&] { return type_message(std::string(element), opt, result); });
+            ++rejected;
+          }
+        };
+
+        if (opt.collection == Property::Collection::SCALAR) {
+          keep(0, args.size());
+          return;
+        }
+
+        // exact reserves for a list given again would defeat their growth
+        if (values.empty()) {
+          std::size_t elements = std::count(args.cbegin(), args.cend(), ',') + 1;
+
+          values.reserve(elements);
+          text.reserve(elements);
+        }
+
+        // like getline, a trailing comma does not add an empty element
+        for (std::size_t begin = 0; begin < args.size();) {
+          std::size_t comma = args.find(',', begin);
+
+          if (comma == std::string::npos) {
+            comma = args.size();
+          }
+
+          keep(begin, comma);
+          begin = comma + 1;
+        }
+      };
+
+      if (opt.type == Property::Arg_Type::INTEGER) {
+        convert(infop->integer_lists[opt.name]);
+      }
+      else {
+        convert(infop->float_lists[opt.name]);
+      }
+
+      text.keep(std::move(args));
+
+      if (opt.collection == Property::Collection::LIST) {
+        CMDPARSE_PROBE3(list__check, fail.base + arg_index, kept, rejected);
+      }
+
+      return (kept > 0);
+    }
+    else {
+      std::string::size_type begin = 0;
+      std::size_t kept = 0, rejected = 0;
+
+      // like getline, a trailing comma does not add an empty element
+      while (begin < args.size()) {
+        std::string::size_type comma = args.find(',', begin);
+
+        if (comma == std::string::npos) {
+          comma = args.size();
+        }
+
+        std::string data  = args.substr(begin, comma - begin);
+        Error_Code result = verify_arg_type(data, opt);
+
+        if (result != Error_Code::NONE) {
+          fail(result, arg_index, arg_offset + begin, &opt,
+              [&] { return type_message(data, opt, result); });
+          ++rejected;
+        }
+        else if (infop->is_interning) {
+          infop->interned_lists[opt.name].push_back(infop->pool.intern(data));
+          ++kept;
+        }
+        else {
+          infop->data.insert(std::make_pair(opt.name, data));
+          ++kept;
+        }
+
+        begin = comma + 1;
+      }
+
+      CMDPARSE_PROBE3(list__check, fail.base + arg_index, kept, rejected);
+
+      return (kept > 0);
+    }
+  }
+
+  /*
+   * base is the position of argv within the argv of the outermost call.
+   * a delegated command leaves arguments it does not consume in argv
+   * for the command that delegated to it, and lists them in left;
+   * consumed arguments are replaced with the empty string. the command
+   * above visits only the listed words, so a chain of subcommands
+   * reads each word a number of times independent of its depth.
+   */
+  void Command::parse_into(char ** argv, int argc, Info * infop, Diagnostics * diags,
+                           int base, Leftover * left, Presence * found) const {
+    std::shared_ptr<Option> opt;
+    int index      = 0;
+    bool delegated = (left != nullptr);
+
+    Reporter fail{ diags, base, "" };
+    Probe_Span span(argc, base, diags, !delegated);
+
+    /*
+     * which options the parse finds, for the constraints. rules are
+     * rare, so nothing is kept unless this command has some. a caller
+     * that adds options from elsewhere passes found and checks itself
+     */
+    Presence own;
+    Presence& presence = found ? *found : own;
+
+    if (!this->rules.empty() && presence.present.empty()) {
+      presence.present.resize(id_count() / 64 + 1);
+      presence.seen.resize(id_count(), -1);
+    }
+
+    auto mark = [&](const Option& opt, int at) {
+      presence.mark(opt, base + at);
+    };
+
+    if (index > argc - 1) {
+      return;
+    }
+
+    // try to get this command's name unless it is empty string
+    if (!this->name.empty()) {
+      if (this->name == argv[index]) {
+        argv[index++] = consumed_word;
+        infop->commands.insert(this->name);
+      }
+      else {
+        fail(Error_Code::COMMAND_NOT_FOUND, index, 0, nullptr,
+            [] { return std::string("command not found"); });
+
+        if (delegated) {
+          left->tail = index;
+        }
+
+        return;
+      }
+    }
+
+    // what the subcommand left, at its position in argv
+    Leftover below{ {}, argc };
+    std::size_t below_at = 0;
+    int sub              = -1;
+
+    /* BLOCK: delegate to command if this command owns any */
+    if (!commands.empty()) {
+      auto cmd_iter = (index < argc) ? commands.find(argv[index]) : commands.cend();
+
+      if (cmd_iter == commands.cend()) {
+        fail(Error_Code::UNKNOWN_COMMAND, index, 0, nullptr,
+            [] { return std::string("initial argument does not match any command"); });
+      }
+      else {
+        CMDPARSE_PROBE2(command__dispatch, base + index, argc - index);
+
+        sub        = index;
+        below.tail = argc - index;
+        cmd_iter->second->parse_into(argv + index, argc - index, infop,
+                                     diags, base + index, &below);
+      }
+    }
+
+    /*
+     * the word after at: the next one the subcommand left if there was
+     * one, else simply the next. a word this command does not consume
+     * either is listed for the command above
+     */
+    auto next = [&](int at) {
+      if (delegated && argv[at] != consumed_word && argv[at][0] != '\0') {
+        left->words.push_back(at);
+      }
+
+      if (sub < 0 || at + 1 >= sub + below.tail) {
+        return at + 1;
+      }
+
+      while (below_at < below.words.size() && sub + below.words[below_at] <= at) {
+        ++below_at;
+      }
+
+      return (below_at < below.words.size()) ? sub + below.words[below_at]
+                                             : sub + below.tail;
+    };
+
     /* BLOCK: parse the rest of the args not handled by sub commands */
-    for (; index < argc; ++index) {
+    for (; index < argc; index = next(index)) {
       std::string handle = argv[index];
 
       if (handle.empty()) continue;
 
       if (handle == "-" || handle == "--") {
-        argv[index] = (char*)"";
+        // leave the end of input for the outermost command, keeping rest in order
+        if (delegated) {
+          left->tail = index;
+          break;
+        }
+
+        argv[index] = consumed_word;
 
         ++index;
         while (index < argc) {
           infop->rest.emplace_back(argv[index]);
-          argv[index++] = (char*)"";
+          argv[index++] = consumed_word;
         }
 
-        return *infop;
+        break;
       }
 
-      auto eq_loc = handle.find_first_of('=');
-      std::unordered_map<std::string, std::shared_ptr<Option>>::const_iterator iter;
+      auto eq_loc    = handle.find_first_of('=');
+      bool ambiguous = false;
+      const handle_map_t::value_type * iter;
 
       /* BLOCK: get the option.
        * when no '=' is present, the entire string is presumed to be an
@@ -685,224 +2059,238 @@ namespace cli {
             && (is_bsd_opt_enabled || is_merged_opt_enabled)) {
 
           bool accepted_first_special = false;
-          char mini_handle;
-
-          for (int j = 0; j < handle.size(); ++j) {
-            // eliminate any prefix characters
-            if (j == 0) {
-              j = skip_prefix(handle);
-              
-              if (is_bsd_opt_enabled && j > 0) {
-                throw parse_error(std::string("bsd-style options may ")
-                    + "not use a prefix");
-              }
-            }
+          bool failed                 = false;
+          int j                       = skip_prefix(handle);
 
-            /*
-             * test this char; if it is not a handle, error
-             * if it is a handle, record it
-             */
-            if (is_case_sensitive) {
-              mini_handle = handle[j];
-            }
-            else {
-              mini_handle = tolower(handle[j]);
-            }
+          // eliminate any prefix characters
+          if (j < 0) {
+            fail(Error_Code::INVALID_PREFIX, index, 0, nullptr,
+                [] { return std::string("invalid prefix"); });
+            continue;
+          }
 
-            iter = this->handles.find(std::string(1, mini_handle));
-            opt  = iter->second;
+          if (is_bsd_opt_enabled && j > 0) {
+            fail(Error_Code::SPECIAL_PREFIX, index, 0, nullptr,
+                [] { return std::string("bsd-style options may ")
+                              + "not use a prefix"; });
+            continue;
+          }
 
-            if (iter == this->handles.cend()) {
-              if (accepted_first_special) {
-                throw parse_error(std::string("all or none of the")
-                    + " characters in the first argument must special");
-              }
-              else {
-                // abandon processing if the first char is not special
-                break; 
-              }
-            }
-            else {
-              if (opt->assignment == Property::Assignment::NO_ASSIGN) {
-                // option repeated too many times
-                if (opt->number == Property::Number::ZERO_ONE
-                    && infop->data.find(opt->name) != infop->data.cend()) {
+          /*
+           * test each char; if it is not a handle, error
+           * if it is a handle, record it
+           */
+          for (; j < (int)handle.size(); ++j) {
+            char mini_handle = is_case_sensitive ? handle[j] : tolower(handle[j]);
 
-                  throw parse_error(std::string("option repeated more than allowed"));
-                }
+            iter = find_handle(std::string(1, mini_handle));
+            CMDPARSE_PROBE2(option__lookup, base + index, (iter ? iter->second->id : -1));
 
-                infop->data.insert(std::make_pair(opt->name, args));
-                accepted_first_special = true;
-              }
-              else {
-                throw parse_error(std::string("cannot assign to a bsd ")
-                    + "or merged option");
+            if (iter == nullptr) {
+              if (accepted_first_special) {
+                fail(Error_Code::SPECIAL_MIXED, index, j, nullptr,
+                    [] { return std::string("all or none of the")
+                                  + " characters in the first argument must special"; });
+                failed = true;
               }
-            }
-          }
 
-          if (accepted_first_special)
-            continue;
+              // abandon processing if the first char is not special
+              break;
+            }
 
-          iter = this->handles.find(handle);
-        }
-        else {
-          if (is_case_sensitive) {
-            if (handle.size() >= 2 && handle[0] == '-' && isupper(handle[1])) {
-              iter = this->handles.find(handle.substr(0, 2));
+            opt = iter->second;
 
-              if (iter == this->handles.cend()) {
-                iter = this->handles.find(handle);
-              }
+            if (opt->assignment != Property::Assignment::NO_ASSIGN) {
+              fail(Error_Code::SPECIAL_ASSIGN, index, j, opt.get(),
+                  [] { return std::string("cannot assign to a bsd ")
+                                + "or merged option"; });
+              failed = true;
+              break;
             }
-            else {
-              iter = this->handles.find(handle);
+
+            // option repeated too many times
+            if (opt->number == Property::Number::ZERO_ONE && infop->has(opt->name)) {
+              fail(Error_Code::REPEATED, index, j, opt.get(),
+                  [] { return std::string("option repeated more than allowed"); });
+              failed = true;
+              break;
             }
+
+            infop->data.insert(std::make_pair(opt->name, std::string("")));
+            mark(*opt, index);
+            accepted_first_special = true;
           }
-          else {
-            iter = this->handles.find(strtolower(handle));
+
+          if (accepted_first_special || failed) {
+            argv[index] = consumed_word;
+            continue;
           }
         }
       }
-      else {
-        if (index == 0 && (is_bsd_opt_enabled || is_merged_opt_enabled)) {
-          throw parse_error(std::string("special options may not take arguments"));
-        }
-        
-        if (is_case_sensitive) {
-          iter = this->handles.find(handle.substr(0, eq_loc));
-        }
-        else {
-          iter = this->handles.find(strtolower(handle.substr(0, eq_loc)));
-        }
+      else if (index == 0 && (is_bsd_opt_enabled || is_merged_opt_enabled)) {
+        fail(Error_Code::SPECIAL_ASSIGN, index, eq_loc, nullptr,
+            [] { return std::string("special options may not take arguments"); });
+        continue;
+      }
+
+      iter = find_option(handle, eq_loc, ambiguous);
+      CMDPARSE_PROBE2(option__lookup, base + index, (iter ? iter->second->id : -1));
+
+      if (ambiguous) {
+        argv[index] = consumed_word;
+
+        fail(Error_Code::AMBIGUOUS_OPTION, index, 0, nullptr,
+            [&] {
+              std::string key = handle.substr(0, eq_loc);
+
+              if (!is_case_sensitive) {
+                key = strtolower(key);
+              }
+
+              std::string msg = std::string("option '") + key
+                  + "' is ambiguous; possibilities:";
+
+              for (const std::string& other : prefixed(key)) {
+                msg += " " + other;
+              }
+
+              return msg;
+            });
+        continue;
       }
  
       /* BLOCK: decide what to do with potential option.
        * if not found in handles, probably an error.
        * otherwise, verify properties
        */
-      if (iter == this->handles.cend()) {
+      if (iter == nullptr) {
         if (is_prefix_char(handle[0]) && is_error_unknown_enabled) {
+          // named commands leave unknown options to the command above them
           if (this->name.empty()) {
-            throw parse_error(std::string("unknown option with handle: ") + handle);
+            fail(Error_Code::UNKNOWN_OPTION, index, 0, nullptr,
+                [&] { return std::string("unknown option with handle: ")
+                              + handle + did_you_mean(suggest(handle)); });
           }
         }
-        else {
+        else if (!delegated) {
           infop->rest.push_back(handle);
-          continue;
         }
+
+        continue;
       }
-      else {
-        opt = iter->second;
 
-        // compare option requirements with data and insert into map
-        if (opt->number == Property::Number::ZERO_ONE
-            && infop->data.find(opt->name) != infop->data.cend()) {
+      opt = iter->second;
+      argv[index] = consumed_word;
+
+      // "--no-" handles undo every earlier use of the flag
+      if (opt->negated) {
+        infop->forget(opt->name);
+        mark(*opt, index);
+        continue;
+      }
+
+      // an option counts as given only once something of it is kept
+      int given = index;
+
+      // compare option requirements with data and insert into map
+      if (opt->number == Property::Number::ZERO_ONE && infop->has(opt->name)) {
+        fail(Error_Code::REPEATED, index, 0, opt.get(),
+            [&] { return std::string("no-repeat option with handle '")
+                          + handle + "' found more than once"; });
+        continue;
+      }
 
-          throw parse_error(std::string("no-repeat option with handle '")
-              + handle + "' found more than once");
+      std::string args("");
+      int arg_index          = index;
+      std::size_t arg_offset = 0;
+
+      switch (opt->assignment) {
+      case Property::Assignment::NO_ASSIGN:
+        if (eq_loc == std::string::npos) {
+          infop->data.insert(std::make_pair(opt->name, args));
+          mark(*opt, given);
         }
         else {
-          switch (opt->assignment) {
-          case Property::Assignment::NO_ASSIGN:
-            if (eq_loc == std::string::npos) {
-              infop->data.insert(std::make_pair(opt->name, args));
-            }
-            else {
-              throw parse_error(std::string("option with handle '")
-                  + handle + "' should not have an argument");
-            }
-
-            break;
-          case Property::Assignment::EQ_REQUIRED:
-            if (eq_loc == std::string::npos) {
-              throw parse_error(std::string("option with handle '")
-                  + handle + "' is missing equals sign");
-            }
-            else {
-              args = handle.substr(eq_loc+1);
-            }
+          fail(Error_Code::UNEXPECTED_ARGUMENT, index, eq_loc, opt.get(),
+              [&] { return std::string("option with handle '")
+                            + handle + "' should not have an argument"; });
+        }
 
-            break;
-          case Property::Assignment::EQ_MAYBE:
-            if (eq_loc == std::string::npos) {
-              if (++index < argc) {
-                args = argv[index];  
-              }
-              else {
-                throw parse_error(std::string("option with handle '")
-                    + handle + "' missing an argument");
-              }
-            }
-            else {
-              args = handle.substr(eq_loc+1);
-            }
+        continue;
+      case Property::Assignment::EQ_REQUIRED:
+        if (eq_loc == std::string::npos) {
+          fail(Error_Code::MISSING_EQUALS, index, handle.size(), opt.get(),
+              [&] { return std::string("option with handle '")
+                            + handle + "' is missing equals sign"; });
+          continue;
+        }
 
-            break;
-          case Property::Assignment::EQ_NEVER:
-            if (eq_loc == std::string::npos) {
-              if (++index < argc) {
-                args = argv[index];
-              }
-              else {
-                throw parse_error(std::string("option with handle '")
-                    + handle + "' missing an argument");
-              }
-            }
-            else {
-              throw parse_error(std::string("option with handle '")
-                  + handle + "' should not use an equals sign");
-            }
+        args       = handle.substr(eq_loc+1);
+        arg_offset = eq_loc + 1;
 
-            break;
-          default:
-            if (handle.size() < 3) {
-              throw parse_error(std::string("option declared with ")
-                  + "stuck assignment must have an argument");
-            }
+        break;
+      case Property::Assignment::EQ_MAYBE:
+        if (eq_loc != std::string::npos) {
+          args       = handle.substr(eq_loc+1);
+          arg_offset = eq_loc + 1;
 
-            args = handle.substr(2);
+          break;
+        }
 
-            break;
-          }
+        [[fallthrough]];
+      case Property::Assignment::EQ_NEVER:
+        if (eq_loc != std::string::npos) {
+          fail(Error_Code::UNEXPECTED_ARGUMENT, index, eq_loc, opt.get(),
+              [&] { return std::string("option with handle '")
+                            + handle + "' should not use an equals sign"; });
+          continue;
+        }
 
-          if (opt->assignment == Property::Assignment::NO_ASSIGN) {
-            continue;
-          }
+        if (index + 1 >= argc) {
+          fail(Error_Code::MISSING_ARGUMENT, index, handle.size(), opt.get(),
+              [&] { return std::string("option with handle '")
+                            + handle + "' missing an argument"; });
+          continue;
+        }
 
-          if (opt->collection == Property::Collection::SCALAR) {
-            if (infop->data.find(opt->name) == infop->data.cend()) {
-              if (verify_arg_type(args, opt->type)) {
-                infop->data.insert(std::make_pair(opt->name, args));
-              }
-              else {
-                throw parse_error(std::string("data '")
-                    + args + "' does not match its declared type");
-              }
-            }
-            else {
-              throw parse_error(std::string("handle repeated: ") + handle);
-            }
-          }
-          else {
-            std::istringstream src(args);
-            std::string data;
+        args        = argv[++index];
+        arg_index   = index;
+        argv[index] = consumed_word;
 
-            while (std::getline(src, data, ',')) {
-              if (verify_arg_type(data, opt->type)) {
-                infop->data.insert(std::make_pair(opt->name, data));
-              }
-              else {
-                throw parse_error(std::string("data '")
-                    + data + "' does not match declared type");
-              }
-            }
-          }
+        break;
+      default:
+        // STUCK and PREFIX: the argument is the rest of the word
+        if (handle.size() <= iter->first.size()) {
+          fail(Error_Code::MISSING_ARGUMENT, index, handle.size(), opt.get(),
+              [] { return std::string("option declared with ")
+                            + "stuck assignment must have an argument"; });
+          continue;
         }
+
+        args       = handle.substr(iter->first.size());
+        arg_offset = iter->first.size();
+
+        break;
+      }
+
+      // a repeatable prefix family such as "-D*=&s" takes a value each time
+      if (opt->collection == Property::Collection::SCALAR
+          && !(opt->assignment == Property::Assignment::PREFIX
+               && opt->number == Property::Number::ZERO_MANY)
+          && infop->has(opt->name)) {
+        fail(Error_Code::REPEATED, index, 0, opt.get(),
+            [&] { return std::string("handle repeated: ") + handle; });
+        continue;
+      }
+
+      if (store(*opt, std::move(args), arg_index, arg_offset, infop, fail)) {
+        mark(*opt, given);
       }
     }
-  
-    return *infop;
+
+    if (!this->rules.empty() && found == nullptr) {
+      check_rules(presence, base + argc, diags);
+    }
   }
 
   Info Command::operator()(char ** argv, int argc) {
@@ -914,6 +2302,9 @@ namespace cli {
       throw command_error(std::string("special options cannot be enabled on named commands"));
     }
 
+    check_unshared();
+    this->revision = next_revision();
+
     if (spec == std::string("ignore_case")) {
       this->is_case_sensitive = false;
     }
@@ -932,16 +2323,397 @@ namespace cli {
     else if (spec == std::string("no_merged_opt")) {
       this->is_merged_opt_enabled = false;
     }
+    else if (spec == std::string("abbrev")) {
+      this->is_abbrev_enabled = true;
+    }
+    else if (spec == std::string("no_abbrev")) {
+      this->is_abbrev_enabled = false;
+    }
     else {
       throw command_error("unrecognized configuration directive");
     }
   }
 
+  std::vector<std::string> Command::complete(const char * const * argv,
+                                             int argc, int cursor) const {
+    std::vector<const Command *> chain{ this };
+    std::vector<std::string> results;
+    std::string word = (cursor < argc) ? argv[cursor] : "";
+    int index        = 0;
+
+    // each range is sorted, so appending and merging keeps results sorted
+    auto add_range = [&results](const Prefix_Index& source, const std::string& prefix) {
+      auto rng          = source.range(prefix);
+      std::size_t split = results.size();
+
+      results.reserve(split + (rng.second - rng.first));
+      results.insert(results.end(), rng.first, rng.second);
+      std::inplace_merge(results.begin(), results.begin() + split, results.end());
+    };
+
+    if (cursor < 0 || cursor > argc) {
+      return results;
+    }
+
+    if (!this->name.empty() && index < cursor && this->name == argv[index]) {
+      ++index;
+    }
+
+    /* BLOCK: follow subcommands as far as the words before the cursor go */
+    while (!chain.back()->commands.empty()) {
+      const Command * current = chain.back();
+
+      if (index == cursor) {
+        add_range(current->command_prefixes, word);
+
+        return results;
+      }
+
+      auto cmd_iter = current->commands.find(argv[index]);
+
+      if (cmd_iter == current->commands.cend()) {
+        break;
+      }
+
+      chain.push_back(cmd_iter->second.get());
+      ++index;
+    }
+
+    for (int i = index; i < cursor; ++i) {
+      if (std::string(argv[i]) == "--") {
+        return results;
+      }
+    }
+
+    /*
+     * find the option whose argument is being completed: either the
+     * word holds "handle=", or the previous word is a handle that takes
+     * the next word as its argument
+     */
+    std::string::size_type eq_loc = word.find('=');
+    std::string handle;
+    std::string partial;
+
+    if (eq_loc != std::string::npos) {
+      handle  = word.substr(0, eq_loc);
+      partial = word.substr(eq_loc + 1);
+    }
+    else if (cursor > index && std::string(argv[cursor - 1]).find('=') == std::string::npos) {
+      handle  = argv[cursor - 1];
+      partial = word;
+    }
+
+    if (!handle.empty()) {
+      for (auto cmd = chain.rbegin(); cmd != chain.rend(); ++cmd) {
+        std::string key = (*cmd)->is_case_sensitive ? handle : strtolower(handle);
+        auto iter       = (*cmd)->find_handle(key);
+
+        if (iter == nullptr) {
+          continue;
+        }
+
+        const Option& opt = *iter->second;
+        bool separate     = (opt.assignment == Property::Assignment::EQ_MAYBE
+                             || opt.assignment == Property::Assignment::EQ_NEVER);
+
+        if (eq_loc == std::string::npos && !separate) {
+          break;
+        }
+
+        // choices are sorted, so the matches are one contiguous range
+        auto first = std::lower_bound(opt.choices.cbegin(), opt.choices.cend(), partial);
+        std::string lead = (eq_loc == std::string::npos) ? "" : handle + "=";
+
+        for (; first != opt.choices.cend() && first->compare(0, partial.size(), partial) == 0; ++first) {
+          results.push_back(lead + *first);
+        }
+
+        return results;
+      }
+    }
+
+    if (eq_loc != std::string::npos) {
+      return results;
+    }
+
+    // options unknown to a subcommand are left to the commands above it
+    for (const Command * cmd : chain) {
+      std::string prefix = cmd->is_case_sensitive ? word : strtolower(word);
+
+      for (const Command * layer = cmd; layer != nullptr; layer = layer->base.get()) {
+        add_range(layer->handle_prefixes, prefix);
+      }
+    }
+
+    // a handle may be declared by several commands, or hidden in a base
+    results.erase(std::unique(results.begin(), results.end()), results.end());
+
+    return results;
+  }
+
+  bool Command::serve_completion(int argc, const char * const * argv,
+                                 std::ostream& out) const {
+    if (argc < 3 || std::string(argv[1]) != "--__complete") {
+      return false;
+    }
+
+    int cursor = std::atoi(argv[2]);
+
+    for (const std::string& match : complete(argv + 3, argc - 3, cursor)) {
+      out << match << '\n';
+    }
+
+    return true;
+  }
+
+  bool Command::serve_completion(int argc, const char * const * argv) const {
+    return serve_completion(argc, argv, std::cout);
+  }
+
+  /*
+   * find the option named by arg, up to eq_loc. the exact handle is
+   * tried first, then the longest STUCK or PREFIX handle that begins
+   * arg and, only for tokens with a prefix and at least one more
+   * character, a unique abbreviation.
+   * ambiguous is set when an abbreviation matches several options
+   */
+  const Command::handle_map_t::value_type *
+  Command::find_option(const std::string& arg, std::string::size_type eq_loc,
+                       bool& ambiguous) const {
+    std::string key = arg.substr(0, eq_loc);
+    const handle_map_t::value_type * iter;
+
+    if (!is_case_sensitive) {
+      key = strtolower(key);
+    }
+
+    iter = find_handle(key);
+
+    if (iter == nullptr) {
+      std::size_t length = 0;
+
+      for (const Command * layer = this; layer != nullptr; layer = layer->base.get()) {
+        if (!layer->patterns.empty()) {
+          length = std::max(length, layer->patterns.longest(key));
+        }
+      }
+
+      if (length > 0) {
+        return find_handle(key.substr(0, length));
+      }
+    }
+
+    if (iter == nullptr && is_abbrev_enabled) {
+      int prefix_size = skip_prefix(key);
+
+      if (prefix_size > 0 && prefix_size < (int)key.size()) {
+        iter = find_abbreviation(key, ambiguous);
+      }
+    }
+
+    return iter;
+  }
+
+  Error_Code Command::verify(const std::string& arg, const Option& opt) {
+    return verify_arg_type(arg, opt);
+  }
+
+  Error_Code Command::verify_entry(const std::string& arg, const Option& opt,
+                                   std::size_t& offset) {
+    std::string_view key, value;
+
+    return verify_map_entry(arg, opt, key, value, offset);
+  }
+
+  /*
+   * find the only option with a handle that begins with key. handles
+   * of one option may share the prefix; ambiguous is set when handles
+   * of different options do
+   */
+  const Command::handle_map_t::value_type *
+  Command::find_abbreviation(const std::string& key, bool& ambiguous) const {
+    const handle_map_t::value_type * found = nullptr;
+
+    for (const Command * layer = this; layer != nullptr; layer = layer->base.get()) {
+      auto rng = layer->handle_prefixes.range(key);
+
+      for (auto i = rng.first; i != rng.second; ++i) {
+        auto candidate = find_handle(*i);
+
+        if (found == nullptr) {
+          found = candidate;
+        }
+        else if (candidate->second->name != found->second->name) {
+          ambiguous = true;
+
+          return nullptr;
+        }
+      }
+    }
+
+    return found;
+  }
+
+  /*
+   * the handle is looked up here first, then in each base in turn,
+   * so a handle declared on a Command hides the same one of its base
+   */
+  const Command::handle_map_t::value_type *
+  Command::find_handle(const std::string& handle) const {
+    for (const Command * layer = this; layer != nullptr; layer = layer->base.get()) {
+      auto iter = layer->handles.find(handle);
+
+      if (iter != layer->handles.cend()) {
+        return &*iter;
+      }
+    }
+
+    return nullptr;
+  }
+
+  int Command::find_id(const std::string& name) const {
+    for (const Command * layer = this; layer != nullptr; layer = layer->base.get()) {
+      auto iter = layer->ids.find(name);
+
+      if (iter != layer->ids.cend()) {
+        return iter->second;
+      }
+    }
+
+    return -1;
+  }
+
+  int Command::id_count() const noexcept {
+    return this->first_id + this->names.size();
+  }
+
+  // handles of this Command and its bases that begin with key, sorted
+  std::vector<std::string> Command::prefixed(const std::string& key) const {
+    std::vector<std::string> results;
+
+    for (const Command * layer = this; layer != nullptr; layer = layer->base.get()) {
+      auto rng          = layer->handle_prefixes.range(key);
+      std::size_t split = results.size();
+
+      results.insert(results.end(), rng.first, rng.second);
+      std::inplace_merge(results.begin(), results.begin() + split, results.end());
+    }
+
+    results.erase(std::unique(results.begin(), results.end()), results.end());
+
+    return results;
+  }
+
+  Command Command::clone() const {
+    Command copy(*this);
+
+    for (auto& cmd : copy.commands) {
+      cmd.second = std::make_shared<Command>(cmd.second->clone());
+    }
+
+    return copy;
+  }
+
+  std::uint64_t Command::generation() const noexcept {
+    std::uint64_t latest = this->base ? std::max(this->revision, this->base->generation())
+                                      : this->revision;
+
+    for (const auto& cmd : this->commands) {
+      latest = std::max(latest, cmd.second->generation());
+    }
+
+    return latest;
+  }
+
+  Memory_Usage Command::memory_usage() const {
+    std::unordered_set<const Option *> seen;
+    std::size_t own = table_bytes(this->handles) + table_bytes(this->ids)
+                    + this->names.capacity() * sizeof(std::string)
+                    + this->handle_index.bytes() + this->handle_prefixes.bytes()
+                    + this->patterns.bytes();
+
+    for (const auto& handle : this->handles) {
+      own += heap_bytes(handle.first);
+
+      // one allocation holds the option and its count of owners
+      if (seen.insert(handle.second.get()).second) {
+        own += sizeof(Option) + 2 * sizeof(long) + heap_bytes(handle.second->name)
+             + handle.second->choices.capacity() * sizeof(std::string);
+
+        for (const std::string& choice : handle.second->choices) {
+          own += heap_bytes(choice);
+        }
+      }
+    }
+
+    for (const auto& id : this->ids) {
+      own += heap_bytes(id.first);
+    }
+
+    for (const std::string& name : this->names) {
+      own += heap_bytes(name);
+    }
+
+    if (!this->base) {
+      return Memory_Usage{ own, 0 };
+    }
+
+    Memory_Usage below = this->base->memory_usage();
+
+    return Memory_Usage{ own, below.own + below.shared };
+  }
+
+  const std::string& Command::option_name(int id) const {
+    if (id < this->first_id) {
+      if (id < 0) {
+        throw std::out_of_range("option id out of range");
+      }
+
+      return this->base->option_name(id);
+    }
+
+    return this->names.at(id - this->first_id);
+  }
+
+  std::vector<std::string> Command::suggest(const std::string& arg) const {
+    std::string handle = arg.substr(0, arg.find_first_of('='));
+
+    if (!is_case_sensitive) {
+      handle = strtolower(handle);
+    }
+
+    // allow roughly one edit per four characters, at most three
+    std::size_t tolerance = std::min<std::size_t>(3, 1 + handle.size() / 4);
+
+    if (!this->base) {
+      return this->handle_index.query(handle, tolerance);
+    }
+
+    std::vector<std::pair<std::size_t, std::string>> found; // distance, handle
+    std::vector<std::string> results;
+
+    for (const Command * layer = this; layer != nullptr; layer = layer->base.get()) {
+      for (std::string& match : layer->handle_index.query(handle, tolerance)) {
+        std::size_t distance = edit_distance(handle, match);
+
+        found.push_back(std::make_pair(distance, std::move(match)));
+      }
+    }
+
+    std::sort(found.begin(), found.end());
+    found.erase(std::unique(found.begin(), found.end()), found.end());
+
+    for (auto& match : found) {
+      results.push_back(std::move(match.second));
+    }
+
+    return results;
+  }
+
   bool Command::handle_has_name(const std::string& handle, const std::string& name) const {
-    const std::unordered_map<std::string, std::shared_ptr<Option>>::const_iterator
-      iter = this->handles.find(handle);
+    const handle_map_t::value_type * iter = find_handle(handle);
 
-    if (iter == this->handles.cend()) {
+    if (iter == nullptr) {
       return false;
     }
     else {
@@ -0,0 +1,162 @@
+/**
+ * \file convert.cpp
+ *
+ * \author Adam Marshall (ih8celery)
+ *
+ * \brief validate and convert numeric option arguments in one pass
+ */
+#include "convert.h"
+#include <charconv>
+#include <limits>
+#include <cctype>
+
+namespace cli {
+  namespace {
+    std::string_view trim(std::string_view in) {
+      while (!in.empty() && isspace(static_cast<unsigned char>(in.front()))) {
+        in.remove_prefix(1);
+      }
+
+      while (!in.empty() && isspace(static_cast<unsigned char>(in.back()))) {
+        in.remove_suffix(1);
+      }
+
+      return in;
+    }
+
+    // strip a leading sign, returning true if it was a minus
+    bool take_sign(std::string_view& in) {
+      if (!in.empty() && (in.front() == '-' || in.front() == '+')) {
+        bool negative = (in.front() == '-');
+
+        in.remove_prefix(1);
+
+        return negative;
+      }
+
+      return false;
+    }
+
+    int take_radix(std::string_view& in) {
+      if (in.size() > 2 && in[0] == '0') {
+        switch (in[1]) {
+        case 'x':
+        case 'X':
+          in.remove_prefix(2);
+          return 16;
+        case 'o':
+        case 'O':
+          in.remove_prefix(2);
+          return 8;
+        case 'b':
+        case 'B':
+          in.remove_prefix(2);
+          return 2;
+        }
+      }
+
+      return 10;
+    }
+
+    // strip a size suffix, returning the number of bits to shift by
+    int take_suffix(std::string_view& in) {
+      if (in.empty()) {
+        return 0;
+      }
+
+      int shift = 0;
+
+      switch (in.back()) {
+      case 'k':
+      case 'K':
+        shift = 10;
+        break;
+      case 'm':
+      case 'M':
+        shift = 20;
+        break;
+      case 'g':
+      case 'G':
+        shift = 30;
+        break;
+      default:
+        return 0;
+      }
+
+      in.remove_suffix(1);
+
+      return shift;
+    }
+  }
+
+  Conversion to_integer(std::string_view arg, std::int64_t& result) noexcept {
+    std::string_view in = trim(arg);
+    bool negative       = take_sign(in);
+    int base            = take_radix(in);
+    int shift           = take_suffix(in);
+    std::uint64_t magnitude;
+
+    if (in.empty()) {
+      return Conversion::BAD_FORMAT;
+    }
+
+    // from_chars rejects signs for unsigned types, so "-+1" or "0x-1" fail here
+    auto [end, ec] = std::from_chars(in.data(), in.data() + in.size(),
+                                     magnitude, base);
+
+    if (ec == std::errc::invalid_argument || end != in.data() + in.size()) {
+      return Conversion::BAD_FORMAT;
+    }
+
+    if (ec == std::errc::result_out_of_range
+        || magnitude > (std::numeric_limits<std::uint64_t>::max() >> shift)) {
+      return Conversion::OUT_OF_RANGE;
+    }
+
+    magnitude <<= shift;
+
+    constexpr std::uint64_t max_positive = std::numeric_limits<std::int64_t>::max();
+
+    if (magnitude > max_positive + (negative ? 1 : 0)) {
+      return Conversion::OUT_OF_RANGE;
+    }
+
+    if (negative) {
+      // negate in unsigned arithmetic so that INT64_MIN does not overflow
+      result = static_cast<std::int64_t>(~magnitude + 1);
+    }
+    else {
+      result = static_cast<std::int64_t>(magnitude);
+    }
+
+    return Conversion::OK;
+  }
+
+  Conversion to_float(std::string_view arg, double& result) noexcept {
+    std::string_view in = trim(arg);
+    bool negative       = take_sign(in);
+    double value;
+
+    // require a digit up front so that inf, nan and a second sign fail
+    if (in.empty()
+        || !(isdigit(static_cast<unsigned char>(in[0]))
+             || (in[0] == '.' && in.size() > 1
+                 && isdigit(static_cast<unsigned char>(in[1]))))) {
+      return Conversion::BAD_FORMAT;
+    }
+
+    auto [end, ec] = std::from_chars(in.data(), in.data() + in.size(), value);
+
+    if (ec == std::errc::invalid_argument || end != in.data() + in.size()) {
+      return Conversion::BAD_FORMAT;
+    }
+
+    if (ec == std::errc::result_out_of_range) {
+      return Conversion::OUT_OF_RANGE;
+    }
+
+    result = negative ? -value : value;
+
+    return Conversion::OK;
+  }
+}
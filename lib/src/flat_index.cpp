@@ -0,0 +1,52 @@
+/**
+ * \file flat_index.cpp
+ *
+ * \author Adam Marshall (ih8celery)
+ *
+ * \brief open-addressing table of indices into an array kept elsewhere
+ */
+#include "flat_index.h"
+#include <functional>
+
+namespace cli {
+  std::size_t Flat_Index::hash(std::string_view key) noexcept {
+    return std::hash<std::string_view>()(key);
+  }
+
+  std::size_t Flat_Index::add(std::size_t hash) {
+    // keep the table at most three quarters full so probes stay short
+    if ((hashes.size() + 1) * 4 > slots.size() * 3) {
+      grow();
+    }
+
+    std::size_t mask = slots.size() - 1;
+    std::size_t at   = hash & mask;
+
+    // the key is absent, so it goes in the first empty slot
+    while (slots[at] != 0) {
+      at = (at + 1) & mask;
+    }
+
+    hashes.push_back(hash);
+    slots[at] = static_cast<std::uint32_t>(hashes.size());
+
+    return hashes.size() - 1;
+  }
+
+  void Flat_Index::grow() {
+    std::size_t size = slots.empty() ? 16 : slots.size() * 2;
+    std::size_t mask = size - 1;
+
+    slots.assign(size, 0);
+
+    for (std::size_t item = 0; item < hashes.size(); ++item) {
+      std::size_t at = hashes[item] & mask;
+
+      while (slots[at] != 0) {
+        at = (at + 1) & mask;
+      }
+
+      slots[at] = static_cast<std::uint32_t>(item + 1);
+    }
+  }
+}
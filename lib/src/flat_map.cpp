@@ -0,0 +1,70 @@
+/**
+ * \file flat_map.cpp
+ *
+ * \author Adam Marshall (ih8celery)
+ *
+ * \brief open-addressing map holding the keys and values of a map option
+ */
+#include "flat_map.h"
+
+namespace cli {
+  const std::string * Flat_Map::find(std::string_view key) const noexcept {
+    std::size_t item = search(key, Flat_Index::hash(key));
+
+    return (item == Flat_Index::npos) ? nullptr : &items[item].second;
+  }
+
+  bool Flat_Map::contains(std::string_view key) const noexcept {
+    return (find(key) != nullptr);
+  }
+
+  void Flat_Map::assign(std::string_view key, std::string_view value) {
+    std::size_t hash = Flat_Index::hash(key);
+    std::size_t item = search(key, hash);
+
+    if (item != Flat_Index::npos) {
+      items[item].second.assign(value.data(), value.size());
+      return;
+    }
+
+    insert(key, value, hash);
+  }
+
+  bool Flat_Map::emplace(std::string_view key, std::string_view value) {
+    std::size_t hash = Flat_Index::hash(key);
+
+    if (search(key, hash) != Flat_Index::npos) {
+      return false;
+    }
+
+    insert(key, value, hash);
+
+    return true;
+  }
+
+  const std::vector<Flat_Map::entry_type>& Flat_Map::entries() const noexcept {
+    return items;
+  }
+
+  std::size_t Flat_Map::size() const noexcept {
+    return items.size();
+  }
+
+  bool Flat_Map::empty() const noexcept {
+    return items.empty();
+  }
+
+  // the item holding key, or Flat_Index::npos
+  std::size_t Flat_Map::search(std::string_view key, std::size_t hash) const noexcept {
+    return index.find(key, hash, [this](std::size_t item) -> std::string_view {
+      return items[item].first;
+    });
+  }
+
+  // add a key known to be absent
+  void Flat_Map::insert(std::string_view key, std::string_view value,
+                        std::size_t hash) {
+    items.emplace_back(std::string(key), std::string(value));
+    index.add(hash);
+  }
+}
@@ -6,16 +6,32 @@
  * \brief parse command line arguments/options
  */
 #include "info.h"
+#include "convert.h"
 
 namespace cli {
+  namespace {
+    // the elements of a typed list, or nullptr if there are none
+    template <typename T>
+    const std::vector<T> * find_list(const std::unordered_map<std::string, std::vector<T>>& lists,
+                                     const std::string& name) {
+      if (lists.empty()) {
+        return nullptr;
+      }
+
+      auto iter = lists.find(name);
+
+      return (iter == lists.cend() || iter->second.empty()) ? nullptr : &iter->second;
+    }
+  }
+
   std::optional<std::string> Info::find(const std::string& name) const {
-    opt_data_t::const_iterator iter = this->data.find(name);
+    auto text = find_text(name);
 
-    if (iter == this->data.cend()) {
+    if (!text) {
       return std::nullopt;
     }
 
-    return std::make_optional(iter->second);
+    return std::make_optional(std::string(*text));
   }
 
   std::optional<std::vector<std::string>> Info::find_all(const std::string& name) const {
@@ -26,6 +42,18 @@ namespace cli {
       results.push_back(start->second);
     }
 
+    if (auto ids = find_ids(name)) {
+      for (std::uint32_t id : *ids) {
+        results.push_back(this->pool.value(id));
+      }
+    }
+
+    if (auto numbers = find_number_text(name)) {
+      for (std::size_t i = 0; i < numbers->size(); ++i) {
+        results.emplace_back((*numbers)[i]);
+      }
+    }
+
     if (results.empty()) {
       return std::nullopt;
     }
@@ -33,12 +61,134 @@ namespace cli {
     return std::make_optional(results);
   }
 
+  std::optional<std::int64_t> Info::find_integer(const std::string& name) const {
+    if (auto integers = find_integers(name)) {
+      return std::make_optional(integers->front());
+    }
+
+    auto text = find_text(name);
+    std::int64_t result;
+
+    if (!text || to_integer(*text, result) != Conversion::OK) {
+      return std::nullopt;
+    }
+
+    return std::make_optional(result);
+  }
+
+  std::optional<double> Info::find_float(const std::string& name) const {
+    if (auto floats = find_floats(name)) {
+      return std::make_optional(floats->front());
+    }
+
+    if (auto integers = find_integers(name)) {
+      return std::make_optional(static_cast<double>(integers->front()));
+    }
+
+    auto text = find_text(name);
+    double result;
+
+    if (!text || to_float(*text, result) != Conversion::OK) {
+      return std::nullopt;
+    }
+
+    return std::make_optional(result);
+  }
+
+  // the first value of an option as it was written
+  std::optional<std::string_view> Info::find_text(const std::string& name) const {
+    opt_data_t::const_iterator iter = this->data.find(name);
+
+    if (iter != this->data.cend()) {
+      return std::make_optional(std::string_view(iter->second));
+    }
+
+    if (auto ids = find_ids(name)) {
+      return std::make_optional(std::string_view(this->pool.value(ids->front())));
+    }
+
+    if (auto numbers = find_number_text(name)) {
+      return std::make_optional((*numbers)[0]);
+    }
+
+    return std::nullopt;
+  }
+
+  const Info::Number_Text * Info::find_number_text(const std::string& name) const {
+    if (this->number_text.empty()) {
+      return nullptr;
+    }
+
+    auto iter = this->number_text.find(name);
+
+    return (iter == this->number_text.cend() || iter->second.size() == 0)
+         ? nullptr : &iter->second;
+  }
+
+  // drop everything found for an option
+  void Info::forget(const std::string& name) {
+    this->data.erase(name);
+    this->maps.erase(name);
+    this->integer_lists.erase(name);
+    this->float_lists.erase(name);
+    this->number_text.erase(name);
+    this->interned_lists.erase(name);
+  }
+
+  const std::vector<std::int64_t> * Info::find_integers(const std::string& name) const {
+    return find_list(this->integer_lists, name);
+  }
+
+  const std::vector<double> * Info::find_floats(const std::string& name) const {
+    return find_list(this->float_lists, name);
+  }
+
+  void Info::intern_values() noexcept {
+    this->is_interning = true;
+  }
+
+  const std::vector<std::uint32_t> * Info::find_ids(const std::string& name) const {
+    return find_list(this->interned_lists, name);
+  }
+
+  const Value_Pool& Info::values() const noexcept {
+    return this->pool;
+  }
+
+  std::optional<std::string_view> Info::lookup(const std::string& name,
+                                               std::string_view key) const {
+    const Flat_Map * map = find_map(name);
+    const std::string * value;
+
+    if (map == nullptr || (value = map->find(key)) == nullptr) {
+      return std::nullopt;
+    }
+
+    return std::make_optional(std::string_view(*value));
+  }
+
+  const Flat_Map * Info::find_map(const std::string& name) const {
+    auto iter = this->maps.find(name);
+
+    return (iter == this->maps.cend()) ? nullptr : &iter->second;
+  }
+
   opt_data_t::size_type Info::count(const std::string& name) const {
-    return data.count(name);
+    const Flat_Map * map                       = maps.empty() ? nullptr : find_map(name);
+    const std::vector<std::int64_t> * integers = find_integers(name);
+    const std::vector<double> * floats         = find_floats(name);
+    const std::vector<std::uint32_t> * ids     = find_ids(name);
+
+    return data.count(name) + (map ? map->size() : 0)
+         + (integers ? integers->size() : 0) + (floats ? floats->size() : 0)
+         + (ids ? ids->size() : 0);
   }
 
   bool Info::has(const std::string& name) const {
-    return (data.find(name) != data.cend());
+    return (data.find(name) != data.cend())
+        || (!maps.empty() && maps.find(name) != maps.cend())
+        || find_integers(name) != nullptr || find_floats(name) != nullptr
+        || find_ids(name) != nullptr;
   }
 
   bool Info::has_command(const std::string& name) const {
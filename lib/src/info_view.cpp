@@ -0,0 +1,542 @@
+/**
+ * \file info_view.cpp
+ *
+ * \author Adam Marshall (ih8celery)
+ *
+ * \brief flat layout of an Info, written by serialize and read in place
+ */
+#include "info_view.h"
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+
+/*
+ * every offset is a uint32_t from the start of the buffer, except
+ * those of strings, which are from the start of the string pool at
+ * the end. a string is a pair (offset, length).
+ *
+ * header:   magic, version, size, option count, options,
+ *           rest count, rest, command count, commands, pool
+ * option:   name (2), kind, count, items, order
+ *           sorted by name, then kind
+ * items:    STRINGS  count strings
+ *           MAP      count pairs of key and value strings, in order of
+ *                    insertion; order is count indices sorted by key
+ *           INTEGERS count int64_t, aligned to 8; order is count
+ *                    strings, the numbers as they were written
+ *           FLOATS   count double, aligned to 8; order as INTEGERS
+ * rest:     rest count strings, in order
+ * commands: command count strings, sorted
+ */
+namespace cli {
+  namespace {
+    constexpr std::uint32_t MAGIC        = 0x4f49'4c43; // "CLIO"
+    constexpr std::uint32_t VERSION      = 2;
+    constexpr std::uint32_t HEADER_WORDS = 10;
+    constexpr std::uint32_t RECORD_WORDS = 6;
+
+    class Writer {
+      public:
+        std::uint32_t offset() const {
+          return out.size();
+        }
+
+        void align(std::size_t to) {
+          out.resize((out.size() + to - 1) / to * to, '\0');
+        }
+
+        // space for n words, to be filled in with put
+        std::uint32_t reserve(std::size_t n) {
+          std::uint32_t at = offset();
+
+          out.resize(out.size() + 4 * n, '\0');
+
+          return at;
+        }
+
+        void put(std::uint32_t at, std::uint32_t value) {
+          std::memcpy(&out[at], &value, 4);
+        }
+
+        void put_string(std::uint32_t at, std::string_view str) {
+          put(at, pool.size());
+          put(at + 4, str.size());
+          pool.append(str);
+        }
+
+        template <typename T>
+        std::uint32_t put_numbers(const std::vector<T>& values) {
+          align(8);
+
+          std::uint32_t at = offset();
+
+          out.append(reinterpret_cast<const char *>(values.data()), values.size() * sizeof(T));
+
+          return at;
+        }
+
+        template <typename Text>
+        std::uint32_t put_text(const Text& text) {
+          std::uint32_t at = reserve(2 * text.size());
+
+          for (std::size_t j = 0; j < text.size(); ++j) {
+            put_string(at + 8 * j, text[j]);
+          }
+
+          return at;
+        }
+
+        std::string finish(std::uint32_t header) {
+          align(8);
+          put(header + 4 * 9, offset());
+          out += pool;
+
+          if (out.size() > UINT32_MAX) {
+            throw std::length_error("Info too large to serialize");
+          }
+
+          put(header + 4 * 2, out.size());
+
+          return std::move(out);
+        }
+
+      private:
+        std::string out;
+        std::string pool;
+    };
+  }
+
+  std::string Info::serialize() const {
+    struct Entry {
+      const std::string * name;
+      Info_View::Kind kind;
+    };
+
+    Writer writer;
+    std::vector<Entry> entries;
+
+    for (auto iter = this->data.cbegin(); iter != this->data.cend();
+         iter = this->data.equal_range(iter->first).second) {
+      entries.push_back(Entry{ &iter->first, Info_View::Kind::STRINGS });
+    }
+
+    for (const auto& list : this->interned_lists) {
+      if (this->data.count(list.first) == 0) {
+        entries.push_back(Entry{ &list.first, Info_View::Kind::STRINGS });
+      }
+    }
+
+    for (const auto& map : this->maps) {
+      entries.push_back(Entry{ &map.first, Info_View::Kind::MAP });
+    }
+
+    for (const auto& list : this->integer_lists) {
+      entries.push_back(Entry{ &list.first, Info_View::Kind::INTEGERS });
+    }
+
+    for (const auto& list : this->float_lists) {
+      entries.push_back(Entry{ &list.first, Info_View::Kind::FLOATS });
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const Entry& l, const Entry& r) {
+      return (*l.name != *r.name) ? (*l.name < *r.name) : (l.kind < r.kind);
+    });
+
+    std::uint32_t header = writer.reserve(HEADER_WORDS);
+    std::uint32_t table  = writer.reserve(RECORD_WORDS * entries.size());
+
+    writer.put(header, MAGIC);
+    writer.put(header + 4, VERSION);
+    writer.put(header + 4 * 3, entries.size());
+    writer.put(header + 4 * 4, table);
+
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+      const std::string& name = *entries[i].name;
+      std::uint32_t at        = table + 4 * RECORD_WORDS * i;
+      std::uint32_t count     = 0;
+      std::uint32_t items     = 0;
+      std::uint32_t order     = 0;
+
+      switch (entries[i].kind) {
+      case Info_View::Kind::STRINGS: {
+        // interned elements are written out like any other
+        auto range = this->data.equal_range(name);
+        auto ids   = find_ids(name);
+        std::uint32_t j = 0;
+
+        count = std::distance(range.first, range.second) + (ids ? ids->size() : 0);
+        items = writer.reserve(2 * count);
+
+        for (; range.first != range.second; ++range.first, ++j) {
+          writer.put_string(items + 8 * j, range.first->second);
+        }
+
+        for (std::size_t k = 0; ids != nullptr && k < ids->size(); ++k, ++j) {
+          writer.put_string(items + 8 * j, this->pool.value((*ids)[k]));
+        }
+
+        break;
+      }
+      case Info_View::Kind::MAP: {
+        const auto& pairs = this->maps.at(name).entries();
+        std::vector<std::uint32_t> sorted(pairs.size());
+
+        count = pairs.size();
+        items = writer.reserve(4 * count);
+
+        for (std::uint32_t j = 0; j < count; ++j) {
+          writer.put_string(items + 16 * j, pairs[j].first);
+          writer.put_string(items + 16 * j + 8, pairs[j].second);
+          sorted[j] = j;
+        }
+
+        std::sort(sorted.begin(), sorted.end(), [&](std::uint32_t l, std::uint32_t r) {
+          return pairs[l].first < pairs[r].first;
+        });
+
+        order = writer.reserve(count);
+
+        for (std::uint32_t j = 0; j < count; ++j) {
+          writer.put(order + 4 * j, sorted[j]);
+        }
+
+        break;
+      }
+      case Info_View::Kind::INTEGERS:
+        count = this->integer_lists.at(name).size();
+        items = writer.put_numbers(this->integer_lists.at(name));
+        order = writer.put_text(this->number_text.at(name));
+        break;
+      case Info_View::Kind::FLOATS:
+        count = this->float_lists.at(name).size();
+        items = writer.put_numbers(this->float_lists.at(name));
+        order = writer.put_text(this->number_text.at(name));
+        break;
+      }
+
+      writer.put_string(at, name);
+      writer.put(at + 8, static_cast<std::uint32_t>(entries[i].kind));
+      writer.put(at + 12, count);
+      writer.put(at + 16, items);
+      writer.put(at + 20, order);
+    }
+
+    std::uint32_t rest = writer.reserve(2 * this->rest.size());
+
+    writer.put(header + 4 * 5, this->rest.size());
+    writer.put(header + 4 * 6, rest);
+
+    for (std::size_t i = 0; i < this->rest.size(); ++i) {
+      writer.put_string(rest + 8 * i, this->rest[i]);
+    }
+
+    std::uint32_t commands = writer.reserve(2 * this->commands.size());
+    std::uint32_t i        = 0;
+
+    writer.put(header + 4 * 7, this->commands.size());
+    writer.put(header + 4 * 8, commands);
+
+    for (const auto& command : this->commands) {
+      writer.put_string(commands + 8 * i++, command);
+    }
+
+    return writer.finish(header);
+  }
+
+  Info Info::deserialize(const void * buffer, std::size_t size) {
+    Info_View view(buffer, size);
+    Info info;
+
+    for (std::uint32_t i = 0; i < view.option_count; ++i) {
+      Info_View::Record rec = view.record(i);
+      std::string name(rec.name);
+
+      switch (rec.kind) {
+      case Info_View::Kind::STRINGS:
+        for (std::uint32_t j = 0; j < rec.count; ++j) {
+          info.data.emplace(name, std::string(view.string_at(rec.items + 8 * j)));
+        }
+        break;
+      case Info_View::Kind::MAP: {
+        Flat_Map& map = info.maps[name];
+
+        for (std::uint32_t j = 0; j < rec.count; ++j) {
+          map.assign(view.string_at(rec.items + 16 * j), view.string_at(rec.items + 16 * j + 8));
+        }
+
+        break;
+      }
+      case Info_View::Kind::INTEGERS: {
+        auto values = view.find_integers(name);
+
+        info.integer_lists[name].assign(values.begin(), values.end());
+        break;
+      }
+      case Info_View::Kind::FLOATS: {
+        auto values = view.find_floats(name);
+
+        info.float_lists[name].assign(values.begin(), values.end());
+        break;
+      }
+      }
+
+      if (rec.kind == Info_View::Kind::INTEGERS || rec.kind == Info_View::Kind::FLOATS) {
+        Number_Text& text = info.number_text[name];
+        std::string word;
+
+        text.reserve(rec.count);
+
+        for (std::uint32_t j = 0; j < rec.count; ++j) {
+          std::string_view number = view.string_at(rec.order + 8 * j);
+
+          text.push_back(word.size(), word.size() + number.size());
+          word.append(number);
+        }
+
+        text.keep(std::move(word));
+      }
+    }
+
+    for (std::size_t i = 0; i < view.rest_size(); ++i) {
+      info.rest.emplace_back(view.rest(i));
+    }
+
+    for (std::uint32_t i = 0; i < view.command_count; ++i) {
+      info.commands.emplace(view.string_at(view.commands + 8 * i));
+    }
+
+    return info;
+  }
+
+  Info_View::Info_View(const void * buffer, std::size_t size)
+      : base(static_cast<const char *>(buffer)) {
+    if (reinterpret_cast<std::uintptr_t>(buffer) % 8 != 0) {
+      throw std::invalid_argument("serialized Info must be aligned to 8 bytes");
+    }
+
+    if (size < 4 * HEADER_WORDS || read(0) != MAGIC || read(4) != VERSION
+        || read(8) > size || read(8) < 4 * HEADER_WORDS) {
+      throw std::invalid_argument("buffer does not hold a serialized Info");
+    }
+
+    bytes         = read(8);
+    option_count  = read(12);
+    options       = read(16);
+    rest_count    = read(20);
+    rest_at       = read(24);
+    command_count = read(28);
+    commands      = read(32);
+    pool          = read(36);
+
+    auto fits = [this](std::uint64_t at, std::uint64_t n, std::uint64_t width) {
+      return at + n * width <= this->pool;
+    };
+
+    if (pool > bytes || !fits(options, option_count, 4 * RECORD_WORDS)
+        || !fits(rest_at, rest_count, 8) || !fits(commands, command_count, 8)) {
+      throw std::invalid_argument("serialized Info has tables out of bounds");
+    }
+  }
+
+  std::uint32_t Info_View::read(std::uint32_t at) const noexcept {
+    std::uint32_t value;
+
+    std::memcpy(&value, base + at, 4);
+
+    return value;
+  }
+
+  std::string_view Info_View::string_at(std::uint32_t at) const noexcept {
+    return std::string_view(base + pool + read(at), read(at + 4));
+  }
+
+  Info_View::Record Info_View::record(std::uint32_t i) const noexcept {
+    std::uint32_t at = options + 4 * RECORD_WORDS * i;
+
+    return Record{ string_at(at), static_cast<Kind>(read(at + 8)),
+                   read(at + 12), read(at + 16), read(at + 20) };
+  }
+
+  // index of the first record with the name, or option_count
+  std::uint32_t Info_View::first_record(std::string_view name) const noexcept {
+    std::uint32_t low = 0, high = option_count;
+
+    while (low < high) {
+      std::uint32_t mid = low + (high - low) / 2;
+
+      if (record(mid).name < name) {
+        low = mid + 1;
+      }
+      else {
+        high = mid;
+      }
+    }
+
+    return (low < option_count && record(low).name == name) ? low : option_count;
+  }
+
+  const Info_View::Record * Info_View::find_record(std::string_view name, Kind kind,
+                                                   Record& out) const noexcept {
+    for (std::uint32_t i = first_record(name); i < option_count; ++i) {
+      out = record(i);
+
+      if (out.name != name) {
+        break;
+      }
+
+      if (out.kind == kind) {
+        return &out;
+      }
+    }
+
+    return nullptr;
+  }
+
+  bool Info_View::has(const std::string& name) const {
+    return first_record(name) != option_count;
+  }
+
+  bool Info_View::has_command(const std::string& name) const {
+    std::uint32_t low = 0, high = command_count;
+
+    while (low < high) {
+      std::uint32_t mid = low + (high - low) / 2;
+
+      if (string_at(commands + 8 * mid) < name) {
+        low = mid + 1;
+      }
+      else {
+        high = mid;
+      }
+    }
+
+    return low < command_count && string_at(commands + 8 * low) == name;
+  }
+
+  // the strings of a record, where numbers keep the text they came from
+  std::uint32_t Info_View::text_at(const Record& rec) const noexcept {
+    return (rec.kind == Kind::STRINGS) ? rec.items : rec.order;
+  }
+
+  std::optional<std::string_view> Info_View::find(const std::string& name) const {
+    for (std::uint32_t i = first_record(name); i < option_count; ++i) {
+      Record rec = record(i);
+
+      if (rec.name != name) {
+        break;
+      }
+
+      if (rec.kind != Kind::MAP && rec.count > 0) {
+        return std::make_optional(string_at(text_at(rec)));
+      }
+    }
+
+    return std::nullopt;
+  }
+
+  std::vector<std::string_view> Info_View::find_all(const std::string& name) const {
+    std::vector<std::string_view> results;
+
+    for (std::uint32_t i = first_record(name); i < option_count; ++i) {
+      Record rec = record(i);
+
+      if (rec.name != name) {
+        break;
+      }
+
+      for (std::uint32_t j = 0; rec.kind != Kind::MAP && j < rec.count; ++j) {
+        results.push_back(string_at(text_at(rec) + 8 * j));
+      }
+    }
+
+    return results;
+  }
+
+  std::size_t Info_View::count(const std::string& name) const {
+    std::size_t total = 0;
+
+    for (std::uint32_t i = first_record(name); i < option_count; ++i) {
+      Record rec = record(i);
+
+      if (rec.name != name) {
+        break;
+      }
+
+      total += rec.count;
+    }
+
+    return total;
+  }
+
+  Number_View<std::int64_t> Info_View::find_integers(const std::string& name) const {
+    Record rec;
+
+    if (find_record(name, Kind::INTEGERS, rec) == nullptr) {
+      return Number_View<std::int64_t>();
+    }
+
+    return Number_View<std::int64_t>(
+        reinterpret_cast<const std::int64_t *>(base + rec.items), rec.count);
+  }
+
+  Number_View<double> Info_View::find_floats(const std::string& name) const {
+    Record rec;
+
+    if (find_record(name, Kind::FLOATS, rec) == nullptr) {
+      return Number_View<double>();
+    }
+
+    return Number_View<double>(reinterpret_cast<const double *>(base + rec.items), rec.count);
+  }
+
+  std::optional<std::string_view> Info_View::lookup(const std::string& name,
+                                                    std::string_view key) const {
+    Record rec;
+
+    if (find_record(name, Kind::MAP, rec) == nullptr) {
+      return std::nullopt;
+    }
+
+    std::uint32_t low = 0, high = rec.count;
+
+    // order holds the indices of the entries sorted by key
+    while (low < high) {
+      std::uint32_t mid = low + (high - low) / 2;
+
+      if (string_at(rec.items + 16 * read(rec.order + 4 * mid)) < key) {
+        low = mid + 1;
+      }
+      else {
+        high = mid;
+      }
+    }
+
+    if (low == rec.count) {
+      return std::nullopt;
+    }
+
+    std::uint32_t entry = rec.items + 16 * read(rec.order + 4 * low);
+
+    if (string_at(entry) != key) {
+      return std::nullopt;
+    }
+
+    return std::make_optional(string_at(entry + 8));
+  }
+
+  std::size_t Info_View::rest_size() const noexcept {
+    return rest_count;
+  }
+
+  std::string_view Info_View::rest(std::size_t i) const {
+    if (i >= rest_count) {
+      throw std::out_of_range("index past the end of rest");
+    }
+
+    return string_at(rest_at + 8 * i);
+  }
+
+  std::size_t Info_View::size() const noexcept {
+    return bytes;
+  }
+}
@@ -0,0 +1,89 @@
+/**
+ * \file live_command.cpp
+ *
+ * \author Adam Marshall (ih8celery)
+ *
+ * \brief a Command that may be changed while other threads parse with it
+ */
+#include "live_command.h"
+
+namespace cli {
+  namespace {
+    // stamps of published versions, never repeated in the process
+    std::atomic<std::uint64_t> stamps{ 0 };
+
+    // a version one thread took from a Live_Command, and its stamp
+    struct Remembered {
+      const Live_Command * owner;
+      std::uint64_t stamp;
+      std::shared_ptr<const Command> version;
+    };
+
+    constexpr std::size_t REMEMBERED = 4;
+
+    thread_local Remembered remembered[REMEMBERED];
+    thread_local std::size_t next_slot;
+  }
+
+  Live_Command::Live_Command(const Command& initial)
+      : current(std::make_shared<const Command>(initial.clone())),
+        stamp(++stamps) {}
+
+  /*
+   * stamps are unique, so a remembered version with the current stamp
+   * is the current version, even if another Live_Command once lived
+   * at the same address
+   */
+  std::shared_ptr<const Command> Live_Command::snapshot() const {
+    std::uint64_t now = this->stamp.load(std::memory_order_acquire);
+    Remembered * slot = nullptr;
+
+    for (Remembered& entry : remembered) {
+      if (entry.owner == this) {
+        if (entry.stamp == now) {
+          return entry.version;
+        }
+
+        slot = &entry;
+      }
+    }
+
+    if (slot == nullptr) {
+      slot = &remembered[next_slot++ % REMEMBERED];
+    }
+
+    Remembered taken{ this, 0, nullptr };
+
+    {
+      std::lock_guard<std::mutex> lock(this->guard);
+
+      taken.stamp   = this->stamp.load(std::memory_order_relaxed);
+      taken.version = this->current;
+    }
+
+    *slot = std::move(taken);
+
+    return slot->version;
+  }
+
+  void Live_Command::update(const std::function<void(Command&)>& edit) {
+    std::lock_guard<std::mutex> lock(this->writer);
+    Command draft = snapshot()->clone();
+
+    edit(draft);
+
+    auto version = std::make_shared<const Command>(std::move(draft));
+    std::lock_guard<std::mutex> swap(this->guard);
+
+    this->current.swap(version);
+    this->stamp.store(++stamps, std::memory_order_release);
+  }
+
+  Info Live_Command::parse(char ** argv, int argc) const {
+    return snapshot()->parse(argv, argc);
+  }
+
+  Info Live_Command::parse(char ** argv, int argc, Diagnostics& diags) const {
+    return snapshot()->parse(argv, argc, diags);
+  }
+}
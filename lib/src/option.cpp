@@ -6,12 +6,21 @@
  * \brief parse command line arguments/options
  */
 #include "option.h"
+#include <limits>
 
 namespace cli {
   Option::Option(): number(Property::Number::ZERO_ONE),
                     assignment(Property::Assignment::NO_ASSIGN),
                     collection(Property::Collection::SCALAR),
-                    type(Property::Arg_Type::STRING) {}
+                    type(Property::Arg_Type::STRING),
+                    key_type(Property::Arg_Type::STRING),
+                    duplicates(Property::Duplicate_Key::LAST),
+                    id(-1),
+                    negated(false),
+                    int_min(std::numeric_limits<std::int64_t>::min()),
+                    int_max(std::numeric_limits<std::int64_t>::max()),
+                    float_min(-std::numeric_limits<double>::infinity()),
+                    float_max(std::numeric_limits<double>::infinity()) {}
 
   bool operator<(const Option& l, const Option& r) noexcept {
     return (l.name < r.name);
@@ -0,0 +1,117 @@
+/**
+ * \file parse_cache.cpp
+ *
+ * \author Adam Marshall (ih8celery)
+ *
+ * \brief remembers the results of parsing the same words again
+ */
+#include "parse_cache.h"
+#include <iterator>
+#include <cstring>
+
+namespace cli {
+  Parse_Cache::Parse_Cache(const Command& cmd, std::size_t size)
+      : command(cmd), capacity(size), generation(cmd.generation()),
+        hit_count(0), miss_count(0) {}
+
+  // 64-bit FNV-1a; the '\0' ending each word keeps "ab" "c" from "a" "bc"
+  std::uint64_t Parse_Cache::hash_words(const char * const * argv, int argc) noexcept {
+    std::uint64_t hash = 14695981039346656037ULL;
+
+    for (int i = 0; i < argc; ++i) {
+      const char * ch = argv[i];
+
+      do {
+        hash = (hash ^ static_cast<unsigned char>(*ch)) * 1099511628211ULL;
+      } while (*ch++ != '\0');
+    }
+
+    return hash;
+  }
+
+  bool Parse_Cache::same_words(const std::string& words, const char * const * argv,
+                               int argc) noexcept {
+    std::size_t at = 0;
+
+    for (int i = 0; i < argc; ++i) {
+      std::size_t length = std::strlen(argv[i]) + 1;
+
+      if (words.size() - at < length || std::memcmp(words.data() + at, argv[i], length) != 0) {
+        return false;
+      }
+
+      at += length;
+    }
+
+    return at == words.size();
+  }
+
+  std::shared_ptr<const Info> Parse_Cache::parse(const char * const * argv, int argc) {
+    if (this->command.generation() != this->generation) {
+      clear();
+      this->generation = this->command.generation();
+    }
+
+    std::uint64_t hash = hash_words(argv, argc);
+    auto range         = this->index.equal_range(hash);
+
+    for (auto iter = range.first; iter != range.second; ++iter) {
+      if (same_words(iter->second->words, argv, argc)) {
+        ++this->hit_count;
+        this->entries.splice(this->entries.begin(), this->entries, iter->second);
+
+        return this->entries.front().info;
+      }
+    }
+
+    ++this->miss_count;
+
+    auto info = std::make_shared<const Info>(this->command.parse(argv, argc));
+
+    if (this->capacity == 0) {
+      return info;
+    }
+
+    if (this->entries.size() == this->capacity) {
+      const Entry& oldest = this->entries.back();
+      auto old_range      = this->index.equal_range(oldest.hash);
+
+      for (auto iter = old_range.first; iter != old_range.second; ++iter) {
+        if (iter->second == std::prev(this->entries.end())) {
+          this->index.erase(iter);
+          break;
+        }
+      }
+
+      this->entries.pop_back();
+    }
+
+    std::string words;
+
+    for (int i = 0; i < argc; ++i) {
+      words.append(argv[i], std::strlen(argv[i]) + 1);
+    }
+
+    this->entries.push_front(Entry{hash, std::move(words), info});
+    this->index.emplace(hash, this->entries.begin());
+
+    return info;
+  }
+
+  std::size_t Parse_Cache::hits() const noexcept {
+    return this->hit_count;
+  }
+
+  std::size_t Parse_Cache::misses() const noexcept {
+    return this->miss_count;
+  }
+
+  std::size_t Parse_Cache::size() const noexcept {
+    return this->entries.size();
+  }
+
+  void Parse_Cache::clear() noexcept {
+    this->entries.clear();
+    this->index.clear();
+  }
+}
@@ -0,0 +1,195 @@
+/**
+ * \file prefix.cpp
+ *
+ * \author Adam Marshall (ih8celery)
+ *
+ * \brief prefix queries over handles
+ */
+#include "prefix.h"
+#include "footprint.h"
+#include <algorithm>
+#include <iterator>
+
+namespace cli {
+  Prefix_Index::Prefix_Index(const Prefix_Index& other) {
+    std::lock_guard<std::mutex> lock(other.guard);
+
+    keys    = other.keys;
+    pending = other.pending;
+    is_sorted.store(pending.empty());
+  }
+
+  Prefix_Index& Prefix_Index::operator=(const Prefix_Index& other) {
+    if (this != &other) {
+      std::scoped_lock lock(guard, other.guard);
+
+      keys    = other.keys;
+      pending = other.pending;
+      is_sorted.store(pending.empty());
+    }
+
+    return *this;
+  }
+
+  void Prefix_Index::insert(const std::string& key) {
+    pending.push_back(key);
+    is_sorted.store(false, std::memory_order_relaxed);
+  }
+
+  void Prefix_Index::insert(std::vector<std::string> batch) {
+    if (pending.empty()) {
+      pending = std::move(batch);
+    }
+    else {
+      pending.insert(pending.end(), std::make_move_iterator(batch.begin()),
+                     std::make_move_iterator(batch.end()));
+    }
+
+    is_sorted.store(pending.empty(), std::memory_order_relaxed);
+  }
+
+  // sort the waiting strings and merge them into keys; guard is held
+  void Prefix_Index::flush() const {
+    std::size_t old_size = keys.size();
+
+    std::sort(pending.begin(), pending.end());
+    keys.insert(keys.end(), std::make_move_iterator(pending.begin()),
+                std::make_move_iterator(pending.end()));
+    std::inplace_merge(keys.begin(), keys.begin() + old_size, keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    pending.clear();
+    is_sorted.store(true, std::memory_order_release);
+  }
+
+  std::pair<Prefix_Index::const_iterator, Prefix_Index::const_iterator>
+  Prefix_Index::range(const std::string& prefix) const {
+    if (!is_sorted.load(std::memory_order_acquire)) {
+      std::lock_guard<std::mutex> lock(guard);
+
+      if (!is_sorted.load(std::memory_order_relaxed)) {
+        flush();
+      }
+    }
+
+    std::size_t length = prefix.size();
+    auto first = std::lower_bound(keys.cbegin(), keys.cend(), prefix);
+
+    // compare only the first length characters, so every key sharing
+    // the prefix counts as equal to it
+    auto last = std::upper_bound(first, keys.cend(), prefix,
+        [length](const std::string& value, const std::string& key) {
+          return key.compare(0, length, value) > 0;
+        });
+
+    return std::make_pair(first, last);
+  }
+
+  std::size_t Prefix_Index::size() const {
+    std::lock_guard<std::mutex> lock(guard);
+
+    if (!pending.empty()) {
+      flush();
+    }
+
+    return keys.size();
+  }
+
+  std::size_t Prefix_Index::bytes() const noexcept {
+    std::lock_guard<std::mutex> lock(guard);
+    std::size_t total = (keys.capacity() + pending.capacity()) * sizeof(std::string);
+
+    for (const std::string& key : keys) {
+      total += heap_bytes(key);
+    }
+
+    for (const std::string& key : pending) {
+      total += heap_bytes(key);
+    }
+
+    return total;
+  }
+
+  void Prefix_Index::clear() noexcept {
+    keys.clear();
+    pending.clear();
+    is_sorted.store(true, std::memory_order_relaxed);
+  }
+
+  void Prefix_Trie::insert(const std::string& key) {
+    if (key.empty()) {
+      return;
+    }
+
+    if (nodes.empty()) {
+      nodes.push_back(Node{{}, false});
+    }
+
+    std::size_t current = 0;
+
+    for (char ch : key) {
+      auto& children = nodes[current].children;
+      auto child     = std::find_if(children.cbegin(), children.cend(),
+          [ch](const std::pair<char, std::size_t>& edge) {
+            return edge.first == ch;
+          });
+
+      if (child == children.cend()) {
+        children.push_back(std::make_pair(ch, nodes.size()));
+        current = nodes.size();
+        nodes.push_back(Node{{}, false});
+      }
+      else {
+        current = child->second;
+      }
+    }
+
+    nodes[current].terminal = true;
+  }
+
+  std::size_t Prefix_Trie::longest(const std::string& str) const {
+    std::size_t found   = 0;
+    std::size_t current = 0;
+
+    if (nodes.empty()) {
+      return 0;
+    }
+
+    for (std::size_t i = 0; i < str.size(); ++i) {
+      const auto& children = nodes[current].children;
+      auto child           = std::find_if(children.cbegin(), children.cend(),
+          [&str, i](const std::pair<char, std::size_t>& edge) {
+            return edge.first == str[i];
+          });
+
+      if (child == children.cend()) {
+        break;
+      }
+
+      current = child->second;
+
+      if (nodes[current].terminal) {
+        found = i + 1;
+      }
+    }
+
+    return found;
+  }
+
+  bool Prefix_Trie::empty() const noexcept {
+    return nodes.empty();
+  }
+
+  std::size_t Prefix_Trie::bytes() const noexcept {
+    std::size_t total = nodes.capacity() * sizeof(Node);
+
+    for (const Node& node : nodes) {
+      total += node.children.capacity() * sizeof(std::pair<char, std::size_t>);
+    }
+
+    return total;
+  }
+
+  void Prefix_Trie::clear() noexcept {
+    nodes.clear();
+  }
+}
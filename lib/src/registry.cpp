@@ -0,0 +1,27 @@
+/**
+ * \file registry.cpp
+ *
+ * \author Adam Marshall (ih8celery)
+ *
+ * \brief options declared by the modules that use them, before main
+ */
+#include "registry.h"
+
+namespace cli {
+  // constant-initialized, so it is ready before any Registration runs
+  std::atomic<Registration *> Registration::head{ nullptr };
+
+  Registration::Registration(const char * option_spec, const char * option_name) noexcept
+      : spec(option_spec), name(option_name), link(head.load(std::memory_order_relaxed)) {
+    while (!head.compare_exchange_weak(link, this, std::memory_order_release,
+                                       std::memory_order_relaxed)) {}
+  }
+
+  const Registration * Registration::first() noexcept {
+    return head.load(std::memory_order_acquire);
+  }
+
+  const Registration * Registration::next() const noexcept {
+    return this->link;
+  }
+}
@@ -0,0 +1,996 @@
+/**
+ * \file session.cpp
+ *
+ * \author Adam Marshall (ih8celery)
+ *
+ * \brief incremental parse of a line that is being edited
+ */
+#include "session.h"
+#include <algorithm>
+#include <stdexcept>
+#include <cctype>
+
+namespace cli {
+  namespace {
+    inline bool is_prefix_char(char ch) {
+      return (ch == ':' || ch == '.' || ch == '-'
+                || ch == '+' || ch == '/');
+    }
+
+    inline bool is_space(char ch) {
+      return isspace(static_cast<unsigned char>(ch));
+    }
+
+    // options that parse reports as repeated when seen a second time
+    inline bool is_limited(const Option& opt) {
+      if (opt.number == Property::Number::ZERO_ONE) {
+        return true;
+      }
+
+      return (opt.assignment != Property::Assignment::NO_ASSIGN
+              && opt.assignment != Property::Assignment::PREFIX
+              && opt.collection == Property::Collection::SCALAR);
+    }
+
+    inline bool differs(const Token& l, const Token& r) {
+      return (l.kind != r.kind || l.error != r.error
+              || l.error_offset != r.error_offset || l.option != r.option);
+    }
+
+    // characters and words in a subtree of the treap, which may be empty
+    template <typename Node>
+    inline std::size_t chars_in(const Node * node) {
+      return (node == nullptr) ? 0 : node->chars;
+    }
+
+    template <typename Node>
+    inline std::size_t count_in(const Node * node) {
+      return (node == nullptr) ? 0 : node->count;
+    }
+  }
+
+  bool Session::State::operator==(const State& other) const noexcept {
+    return (command == other.command && pending == other.pending
+            && expect == other.expect && ended == other.ended && repeat == other.repeat);
+  }
+
+  bool Session::State::operator!=(const State& other) const noexcept {
+    return !(*this == other);
+  }
+
+  bool Session::Earlier::operator()(const Word * l, const Word * r) const {
+    return rank(l) < rank(r);
+  }
+
+  bool Session::Earlier::operator()(const Word * l, std::size_t r) const {
+    return rank(l) < r;
+  }
+
+  bool Session::Earlier::operator()(std::size_t l, const Word * r) const {
+    return l < rank(r);
+  }
+
+  Session::Session(const Command& cmd, const std::string& line): root(cmd),
+                                                                 top(nullptr),
+                                                                 dangling(nullptr),
+                                                                 filled(0),
+                                                                 text_stale(false),
+                                                                 words_stale(false) {
+    std::vector<const Command *> pending{ &root };
+
+    while (!pending.empty()) {
+      const Command * current = pending.back();
+
+      pending.pop_back();
+
+      for (const Command * layer = current; layer != nullptr; layer = layer->base.get()) {
+        for (const auto& handle : layer->handles) {
+          if (is_limited(*handle.second)) {
+            limited.insert(handle.second->name);
+          }
+        }
+      }
+
+      for (const auto& sub : current->commands) {
+        parents.insert(std::make_pair(sub.second.get(), current));
+        pending.push_back(sub.second.get());
+      }
+    }
+
+    reset(line);
+  }
+
+  // the words point into each other, so a copy parses the line again
+  Session::Session(const Session& other): Session(other.root, other.line()) {}
+
+  void Session::reset(const std::string& line) {
+    occurrences.clear();
+    store.clear();
+    unused.clear();
+    filled = 0;
+    lead.clear();
+    top      = nullptr;
+    dangling = nullptr;
+
+    edit(0, 0, line);
+  }
+
+  std::vector<std::size_t> Session::edit(std::size_t offset, std::size_t removed,
+                                         const std::string& inserted) {
+    std::size_t length = lead.size() + chars_in(top);
+
+    if (offset > length) {
+      throw std::out_of_range("edit begins past the end of the line");
+    }
+
+    removed = std::min(removed, length - offset);
+
+    std::size_t end = offset + removed;
+
+    // count the words for which precedes(start, word) holds; they come first
+    auto count_words = [this](auto precedes) {
+      std::size_t result = 0;
+      std::size_t base   = lead.size();
+
+      for (const Word * word = top; word != nullptr;) {
+        std::size_t start = base + chars_in(word->left);
+
+        if (precedes(start, *word)) {
+          result += count_in(word->left) + 1;
+          base    = start + word->text.size();
+          word    = word->right;
+        }
+        else {
+          word = word->left;
+        }
+      }
+
+      return result;
+    };
+
+    // words touching the edit may be joined to it or split by it
+    std::size_t begin = count_words([offset](std::size_t start, const Word& word) {
+      return start + word.token.length < offset;
+    });
+    std::size_t stop  = count_words([end](std::size_t start, const Word&) {
+      return start <= end;
+    });
+
+    /*
+     * the edit falls within the whitespace before the first word it
+     * touches and the text of the words it touches. only that much of
+     * the line is cut into words again
+     */
+    Word * before     = (begin == 0) ? nullptr : at(begin - 1);
+    std::size_t space = (before == nullptr) ? 0 : before->token.length;
+    std::size_t from  = (before == nullptr) ? 0 : offset_of(before) + space;
+    std::string cut   = (before == nullptr) ? lead : before->text.substr(space);
+    std::unordered_set<const std::string *> names;
+    std::vector<std::size_t> changed;
+    std::vector<Word *> fresh;
+
+    Word * word = (begin == stop) ? nullptr : at(begin);
+
+    for (std::size_t index = begin; index < stop; ++index, word = next(word)) {
+      cut += word->text;
+
+      if (counts(*word)) {
+        names.insert(&word->slot.opt->name);
+        occurrences[word->slot.opt->name].erase(word->place);
+      }
+
+      if (word == dangling) {
+        dangling = nullptr;
+      }
+    }
+
+    cut.replace(offset - from, removed, inserted);
+
+    std::size_t i = 0;
+
+    while (i < cut.size() && is_space(cut[i])) {
+      ++i;
+    }
+
+    if (before == nullptr) {
+      lead = cut.substr(0, i);
+    }
+    else {
+      std::size_t old_size = before->text.size();
+
+      before->text.replace(space, std::string::npos, cut, 0, i);
+
+      for (Word * up = before; up != nullptr; up = up->up) {
+        up->chars = up->chars - old_size + before->text.size();
+      }
+    }
+
+    while (i < cut.size()) {
+      std::size_t start = i;
+
+      while (i < cut.size() && !is_space(cut[i])) {
+        ++i;
+      }
+
+      std::size_t word_end = i;
+
+      while (i < cut.size() && is_space(cut[i])) {
+        ++i;
+      }
+
+      fresh.push_back(make_word(cut.substr(start, i - start), word_end - start));
+    }
+
+    Word * left   = nullptr;
+    Word * middle = nullptr;
+    Word * right  = nullptr;
+    Word * added  = build(fresh);
+
+    split(top, begin, left, middle);
+    split(middle, stop - begin, middle, right);
+    release(middle);
+
+    word = fresh.empty() ? leftmost(right) : fresh.front();
+    top  = merge(merge(left, added), right);
+
+    if (top != nullptr) {
+      top->up = nullptr;
+    }
+
+    /*
+     * whether an option is repeated depends on the last word before it
+     * of the same name. a word whose name is gone or new, or that now
+     * keeps its option when it did not, marks the next word of its name
+     */
+    std::set<std::size_t> dirty;
+
+    auto touch = [&dirty](const Occurrences& list, Occurrences::const_iterator iter) {
+      if (iter != list.cend()) {
+        dirty.insert(rank(*iter));
+      }
+    };
+
+    for (const std::string * name : names) {
+      const Occurrences& list = occurrences[*name];
+
+      touch(list, list.lower_bound(begin));
+    }
+
+    /*
+     * match the new words, then the words after them until one is
+     * reached whose state has not changed; from there on nothing can,
+     * except at the next word marked, where matching starts again
+     */
+    State state         = (before == nullptr) ? initial() : before->slot.after;
+    std::size_t index   = begin;
+    std::vector<Word *> visited;
+
+    // whether an option is kept depends on its argument, so it is matched again
+    if (before != nullptr && before->slot.after.pending != nullptr) {
+      dirty.insert(--index);
+      state = before->slot.before;
+      word  = before;
+    }
+
+    // where the next word of each name goes among the words of that name
+    std::unordered_map<std::string, Occurrences::iterator> following;
+
+    while (word != nullptr) {
+      bool is_fresh = (index >= begin && index < begin + fresh.size());
+      bool is_dirty = (!dirty.empty() && *dirty.begin() == index);
+
+      if (is_dirty) {
+        dirty.erase(dirty.begin());
+      }
+      else if (!is_fresh && word->slot.before == state) {
+        if (dirty.empty()) {
+          break;
+        }
+
+        index = *dirty.begin();
+        word  = at(index);
+        state = word->slot.before;
+        continue;
+      }
+
+      Token old          = word->token;
+      bool was_seen      = word->slot.seen;
+      const Option * was = (!is_fresh && counts(*word)) ? word->slot.opt : nullptr;
+
+      word->index = index;
+      visited.push_back(word);
+
+      match(*word, state);
+      state = word->slot.after;
+
+      const Option * now = counts(*word) ? word->slot.opt : nullptr;
+
+      // a word keeps its place among the words of the same name
+      if (was != nullptr && (now == nullptr || now->name != was->name)) {
+        Occurrences& list = occurrences[was->name];
+
+        following[was->name] = list.erase(word->place);
+        touch(list, following[was->name]);
+      }
+      else if (was != nullptr) {
+        following[was->name] = std::next(word->place);
+
+        if (word->slot.seen != was_seen) {
+          touch(occurrences[was->name], following[was->name]);
+        }
+      }
+
+      if (now != nullptr && (was == nullptr || now->name != was->name)) {
+        Occurrences& list = occurrences[now->name];
+        auto hint         = following.find(now->name);
+
+        if (hint == following.end()) {
+          hint = following.insert(std::make_pair(now->name, list.lower_bound(index))).first;
+        }
+
+        word->place  = list.insert(hint->second, word);
+        hint->second = std::next(word->place);
+        touch(list, hint->second);
+      }
+
+      if (is_fresh || differs(old, word->token)) {
+        changed.push_back(index);
+      }
+
+      // the new words are at hand in order; walking the treap costs more
+      if (index + 1 < begin + fresh.size()) {
+        word = fresh[index + 1 - begin];
+      }
+      else {
+        word = next(word);
+      }
+
+      ++index;
+    }
+
+    // the words matched are in order already; only those marked after are not
+    std::size_t in_order = changed.size();
+
+    mark_dangling(changed);
+
+    for (Word * done : visited) {
+      done->index = std::string::npos;
+    }
+
+    std::sort(changed.begin() + in_order, changed.end());
+    std::inplace_merge(changed.begin(), changed.begin() + in_order, changed.end());
+    changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+
+    text_stale  = true;
+    words_stale = true;
+
+    return changed;
+  }
+
+  const std::string& Session::line() const {
+    if (text_stale) {
+      text = lead;
+      text.reserve(lead.size() + chars_in(top));
+
+      for (Word * word = leftmost(top); word != nullptr; word = next(word)) {
+        text += word->text;
+      }
+
+      text_stale = false;
+    }
+
+    return text;
+  }
+
+  const std::vector<Token>& Session::tokens() const {
+    if (words_stale) {
+      std::size_t offset = lead.size();
+
+      words.clear();
+      words.reserve(count_in(top));
+
+      for (Word * word = leftmost(top); word != nullptr; word = next(word)) {
+        words.push_back(word->token);
+        words.back().offset = offset;
+        offset += word->text.size();
+      }
+
+      words_stale = false;
+    }
+
+    return words;
+  }
+
+  Token Session::token(std::size_t index) const {
+    if (index >= size()) {
+      throw std::out_of_range("no token at index");
+    }
+
+    const Word * word = at(index);
+    Token result      = word->token;
+
+    result.offset = offset_of(word);
+
+    return result;
+  }
+
+  std::size_t Session::size() const noexcept {
+    return count_in(top);
+  }
+
+  Diagnostics Session::diagnostics() const {
+    Diagnostics result;
+    std::int32_t index = 0;
+
+    for (Word * word = leftmost(top); word != nullptr; word = next(word), ++index) {
+      const Slot& slot = word->slot;
+
+      // like parse, a word that is not a subcommand is then read as an option
+      if (slot.stray) {
+        result.push_back(Diagnostic{Error_Code::UNKNOWN_COMMAND, 0, index, -1});
+      }
+
+      if (slot.own != Error_Code::NONE) {
+        result.push_back(Diagnostic{slot.own, slot.own_offset, index, word->token.option});
+      }
+      else if (slot.dangling) {
+        result.push_back(Diagnostic{Error_Code::MISSING_ARGUMENT,
+                                    static_cast<std::uint32_t>(word->token.length),
+                                    index, word->token.option});
+      }
+    }
+
+    // a line that ends where a subcommand belongs lacks it, past its last word
+    if (top != nullptr && rightmost(top)->slot.after.expect == Expect::COMMAND) {
+      result.push_back(Diagnostic{Error_Code::UNKNOWN_COMMAND, 0, index, -1});
+    }
+
+    return result;
+  }
+
+  Session::State Session::initial() const noexcept {
+    Expect expect = Expect::OPTION;
+
+    if (!root.name.empty()) {
+      expect = Expect::NAME;
+    }
+    else if (!root.commands.empty()) {
+      expect = Expect::COMMAND;
+    }
+
+    return State{ &root, nullptr, expect, false, false };
+  }
+
+  // match a word as parse would after the words before it left state
+  void Session::match(Word& word, const State& state) {
+    Token& token    = word.token;
+    Slot& slot      = word.slot;
+    std::string arg = word.text.substr(0, token.length);
+
+    slot         = Slot{ state, state, nullptr, Error_Code::NONE, 0, false, false, false };
+    token.kind   = Token_Kind::POSITIONAL;
+    token.option = -1;
+
+    if (state.ended) {
+      // nothing to do; everything after the end of input is positional
+    }
+    else if (state.pending != nullptr) {
+      token.kind         = Token_Kind::ARGUMENT;
+      token.option       = state.pending->id;
+      slot.opt           = state.pending;
+      slot.after.pending = nullptr;
+      slot.after.repeat  = false;
+
+      // like parse, the argument of a repeated option is not checked
+      if (state.repeat) {
+        slot.own = Error_Code::REPEATED;
+      }
+      else {
+        check(arg, 0, slot);
+      }
+    }
+    else if (state.expect == Expect::NAME) {
+      token.kind        = Token_Kind::COMMAND;
+      slot.after.expect = root.commands.empty() ? Expect::OPTION : Expect::COMMAND;
+
+      // like parse, nothing after a wrong name is read
+      if (arg != root.name) {
+        slot.own          = Error_Code::COMMAND_NOT_FOUND;
+        slot.after.expect = Expect::OPTION;
+        slot.after.ended  = true;
+      }
+    }
+    else if (state.expect == Expect::COMMAND) {
+      auto cmd_iter = state.command->commands.find(arg);
+
+      if (cmd_iter != state.command->commands.cend()) {
+        const Command * sub = cmd_iter->second.get();
+
+        token.kind         = Token_Kind::COMMAND;
+        slot.after.command = sub;
+        slot.after.expect  = sub->commands.empty() ? Expect::OPTION : Expect::COMMAND;
+      }
+      else {
+        // like parse, the word is still read as an option afterward
+        slot.after.expect = Expect::OPTION;
+        match_option(word, arg);
+        slot.stray = true;
+      }
+    }
+    else {
+      match_option(word, arg);
+    }
+
+    refresh(word);
+  }
+
+  void Session::match_option(Word& target, const std::string& arg) {
+    Token& word = target.token;
+    Slot& slot  = target.slot;
+
+    if (arg == "-" || arg == "--") {
+      word.kind        = Token_Kind::END;
+      slot.after.ended = true;
+      return;
+    }
+
+    auto eq_loc             = arg.find_first_of('=');
+    bool ambiguous          = false;
+    const Option * opt      = nullptr;
+    std::size_t handle_size = 0;
+
+    // options unknown to a subcommand are left to the commands above it
+    for (const Command * cmd = slot.before.command; cmd != nullptr; cmd = parent(cmd)) {
+      auto iter = cmd->find_option(arg, eq_loc, ambiguous);
+
+      if (ambiguous) {
+        word.kind = Token_Kind::OPTION;
+        slot.own  = Error_Code::AMBIGUOUS_OPTION;
+        return;
+      }
+
+      if (iter != nullptr) {
+        opt         = iter->second.get();
+        handle_size = iter->first.size();
+        break;
+      }
+    }
+
+    if (opt == nullptr) {
+      // like parse, a named command reports no unknown options
+      if (is_prefix_char(arg[0]) && root.is_error_unknown_enabled && root.name.empty()) {
+        word.kind = Token_Kind::OPTION;
+        slot.own  = Error_Code::UNKNOWN_OPTION;
+      }
+
+      return;
+    }
+
+    word.kind   = Token_Kind::OPTION;
+    word.option = opt->id;
+    slot.opt    = opt;
+
+    if (opt->negated) {
+      return;
+    }
+
+    // like parse, a repeat is found before anything else is checked
+    bool seen = seen_before(target);
+
+    if (seen && opt->number == Property::Number::ZERO_ONE) {
+      slot.own  = Error_Code::REPEATED;
+      slot.seen = true;
+      return;
+    }
+
+    // the argument of a scalar given again is not checked, and not kept
+    bool late = seen && opt->collection == Property::Collection::SCALAR
+                && opt->assignment != Property::Assignment::PREFIX;
+
+    auto take = [&](const std::string& args, std::size_t offset) {
+      if (late) {
+        slot.own = Error_Code::REPEATED;
+        return false;
+      }
+
+      return check(args, offset, slot);
+    };
+
+    // the next word is the argument, and decides whether the option is kept
+    auto pend = [&] {
+      const Word * after = next(&target);
+
+      slot.after.pending = opt;
+      slot.after.repeat  = late;
+
+      if (late || after == nullptr) {
+        return false;
+      }
+
+      Slot scratch = slot;
+
+      return check(after->text.substr(0, after->token.length), 0, scratch);
+    };
+
+    bool kept = false;
+
+    switch (opt->assignment) {
+    case Property::Assignment::NO_ASSIGN:
+      if (eq_loc != std::string::npos) {
+        slot.own        = Error_Code::UNEXPECTED_ARGUMENT;
+        slot.own_offset = eq_loc;
+      }
+      else {
+        kept = true;
+      }
+
+      break;
+    case Property::Assignment::EQ_REQUIRED:
+      if (eq_loc == std::string::npos) {
+        slot.own        = Error_Code::MISSING_EQUALS;
+        slot.own_offset = arg.size();
+      }
+      else {
+        kept = take(arg.substr(eq_loc + 1), eq_loc + 1);
+      }
+
+      break;
+    case Property::Assignment::EQ_MAYBE:
+      if (eq_loc != std::string::npos) {
+        kept = take(arg.substr(eq_loc + 1), eq_loc + 1);
+      }
+      else {
+        kept = pend();
+      }
+
+      break;
+    case Property::Assignment::EQ_NEVER:
+      if (eq_loc != std::string::npos) {
+        slot.own        = Error_Code::UNEXPECTED_ARGUMENT;
+        slot.own_offset = eq_loc;
+      }
+      else {
+        kept = pend();
+      }
+
+      break;
+    default:
+      if (arg.size() <= handle_size) {
+        slot.own        = Error_Code::MISSING_ARGUMENT;
+        slot.own_offset = arg.size();
+      }
+      else {
+        kept = take(arg.substr(handle_size), handle_size);
+      }
+
+      break;
+    }
+
+    // counted as given exactly when parse would find it in Info
+    slot.seen = seen || kept;
+  }
+
+  /*
+   * verify the argument found at offset within the word, and return
+   * whether parse would keep any of it. the first problem is recorded
+   */
+  bool Session::check(const std::string& args, std::size_t offset, Slot& slot) const {
+    const Option& opt = *slot.opt;
+
+    if (opt.collection == Property::Collection::SCALAR) {
+      slot.own        = Command::verify(args, opt);
+      slot.own_offset = offset;
+      return (slot.own == Error_Code::NONE);
+    }
+
+    if (opt.collection == Property::Collection::MAP) {
+      std::size_t within = 0;
+
+      slot.own        = Command::verify_entry(args, opt, within);
+      slot.own_offset = offset + within;
+      return (slot.own == Error_Code::NONE);
+    }
+
+    std::string::size_type begin = 0;
+    bool kept = false;
+
+    // like parse, the good elements of a list are kept beside the bad
+    while (begin < args.size()) {
+      std::string::size_type comma = args.find(',', begin);
+
+      if (comma == std::string::npos) {
+        comma = args.size();
+      }
+
+      Error_Code result = Command::verify(args.substr(begin, comma - begin), opt);
+
+      if (result == Error_Code::NONE) {
+        kept = true;
+      }
+      else if (slot.own == Error_Code::NONE) {
+        slot.own        = result;
+        slot.own_offset = offset + begin;
+      }
+
+      begin = comma + 1;
+    }
+
+    return kept;
+  }
+
+  // whether a word uses an option whose repeats are looked for
+  bool Session::counts(const Word& word) const {
+    return (word.token.kind == Token_Kind::OPTION && word.slot.opt != nullptr
+            && limited.count(word.slot.opt->name) > 0);
+  }
+
+  // whether the option of a word was kept by the last word before it of that name
+  bool Session::seen_before(const Word& word) const {
+    auto found = occurrences.find(word.slot.opt->name);
+
+    if (found == occurrences.cend() || limited.count(word.slot.opt->name) == 0) {
+      return false;
+    }
+
+    auto iter = found->second.lower_bound(word.index);
+
+    return (iter != found->second.cbegin() && (*std::prev(iter))->slot.seen);
+  }
+
+  // an option at the end of the line that wants the next word lacks it
+  void Session::mark_dangling(std::vector<std::size_t>& changed) {
+    Word * now = nullptr;
+
+    if (top != nullptr && rightmost(top)->slot.after.pending != nullptr) {
+      now = rightmost(top);
+    }
+
+    if (dangling != nullptr && dangling != now && dangling->slot.dangling) {
+      dangling->slot.dangling = false;
+      refresh(*dangling);
+      changed.push_back(rank(dangling));
+    }
+
+    if (now != nullptr && !now->slot.dangling) {
+      now->slot.dangling = true;
+      refresh(*now);
+      changed.push_back(rank(now));
+    }
+
+    dangling = now;
+  }
+
+  // bring the error of a word in line with its slot
+  void Session::refresh(Word& word) {
+    Token& token     = word.token;
+    const Slot& slot = word.slot;
+
+    if (slot.stray) {
+      token.error        = Error_Code::UNKNOWN_COMMAND;
+      token.error_offset = 0;
+    }
+    else if (slot.own != Error_Code::NONE) {
+      token.error        = slot.own;
+      token.error_offset = slot.own_offset;
+    }
+    else if (slot.dangling) {
+      token.error        = Error_Code::MISSING_ARGUMENT;
+      token.error_offset = token.length;
+    }
+    else {
+      token.error        = Error_Code::NONE;
+      token.error_offset = 0;
+    }
+  }
+
+  const Command * Session::parent(const Command * cmd) const {
+    auto iter = parents.find(cmd);
+
+    return (iter == parents.cend()) ? nullptr : iter->second;
+  }
+
+  Session::Word * Session::make_word(std::string text, std::size_t length) {
+    Word * word = nullptr;
+
+    if (unused.empty()) {
+      if (store.empty() || filled == block_size) {
+        store.emplace_back(new Word[block_size]);
+        filled = 0;
+      }
+
+      word = &store.back()[filled++];
+    }
+    else {
+      word = unused.back();
+      unused.pop_back();
+    }
+
+    word->text     = std::move(text);
+    word->token    = Token{0, length, Token_Kind::POSITIONAL, Error_Code::NONE, 0, -1};
+    word->slot     = Slot{};
+    word->index    = std::string::npos;
+    word->left     = nullptr;
+    word->right    = nullptr;
+    word->up       = nullptr;
+    word->priority = static_cast<std::uint32_t>(priorities());
+    pull(word);
+
+    return word;
+  }
+
+  // keep the words of a subtree for reuse
+  void Session::release(Word * word) {
+    if (word == nullptr) {
+      return;
+    }
+
+    release(word->left);
+    release(word->right);
+    unused.push_back(word);
+  }
+
+  // recount a word after its text or children changed
+  void Session::pull(Word * word) {
+    word->chars = word->text.size() + chars_in(word->left) + chars_in(word->right);
+    word->count = 1 + count_in(word->left) + count_in(word->right);
+
+    if (word->left != nullptr) {
+      word->left->up = word;
+    }
+
+    if (word->right != nullptr) {
+      word->right->up = word;
+    }
+  }
+
+  // the words of l followed by those of r
+  Session::Word * Session::merge(Word * l, Word * r) {
+    if (l == nullptr) {
+      return r;
+    }
+
+    if (r == nullptr) {
+      return l;
+    }
+
+    if (l->priority > r->priority) {
+      l->right = merge(l->right, r);
+      pull(l);
+
+      return l;
+    }
+
+    r->left = merge(l, r->left);
+    pull(r);
+
+    return r;
+  }
+
+  // a treap of words in the order given, made in one pass along its right edge
+  Session::Word * Session::build(const std::vector<Word *>& words) {
+    std::vector<Word *> edge;
+
+    for (Word * word : words) {
+      Word * below = nullptr;
+
+      while (!edge.empty() && edge.back()->priority < word->priority) {
+        below = edge.back();
+        edge.pop_back();
+        pull(below);
+      }
+
+      word->left = below;
+
+      if (!edge.empty()) {
+        edge.back()->right = word;
+      }
+
+      edge.push_back(word);
+    }
+
+    while (edge.size() > 1) {
+      pull(edge.back());
+      edge.pop_back();
+    }
+
+    if (!edge.empty()) {
+      pull(edge.back());
+    }
+
+    return edge.empty() ? nullptr : edge.back();
+  }
+
+  // the first n words of a subtree go to l, the rest to r
+  void Session::split(Word * word, std::size_t n, Word *& l, Word *& r) {
+    if (word == nullptr) {
+      l = nullptr;
+      r = nullptr;
+      return;
+    }
+
+    if (count_in(word->left) < n) {
+      split(word->right, n - count_in(word->left) - 1, word->right, r);
+      pull(word);
+      l = word;
+    }
+    else {
+      split(word->left, n, l, word->left);
+      pull(word);
+      r = word;
+    }
+  }
+
+  Session::Word * Session::leftmost(Word * word) {
+    while (word != nullptr && word->left != nullptr) {
+      word = word->left;
+    }
+
+    return word;
+  }
+
+  Session::Word * Session::rightmost(Word * word) {
+    while (word != nullptr && word->right != nullptr) {
+      word = word->right;
+    }
+
+    return word;
+  }
+
+  // the word after this one in the line, or null
+  Session::Word * Session::next(Word * word) {
+    if (word->right != nullptr) {
+      return leftmost(word->right);
+    }
+
+    while (word->up != nullptr && word->up->right == word) {
+      word = word->up;
+    }
+
+    return word->up;
+  }
+
+  // the index of a word in the line
+  std::size_t Session::rank(const Word * word) {
+    if (word->index != std::string::npos) {
+      return word->index;
+    }
+
+    std::size_t result = count_in(word->left);
+
+    for (; word->up != nullptr; word = word->up) {
+      if (word->up->right == word) {
+        result += count_in(word->up->left) + 1;
+      }
+    }
+
+    return result;
+  }
+
+  std::size_t Session::offset_of(const Word * word) const {
+    std::size_t result = lead.size() + chars_in(word->left);
+
+    for (; word->up != nullptr; word = word->up) {
+      if (word->up->right == word) {
+        result += chars_in(word->up->left) + word->up->text.size();
+      }
+    }
+
+    return result;
+  }
+
+  Session::Word * Session::at(std::size_t index) const {
+    Word * word = top;
+
+    while (count_in(word->left) != index) {
+      if (index < count_in(word->left)) {
+        word = word->left;
+      }
+      else {
+        index -= count_in(word->left) + 1;
+        word   = word->right;
+      }
+    }
+
+    return word;
+  }
+}
@@ -0,0 +1,247 @@
+/**
+ * \file suggest.cpp
+ *
+ * \author Adam Marshall (ih8celery)
+ *
+ * \brief index of handles used to suggest corrections for typos
+ */
+#include "suggest.h"
+#include "footprint.h"
+#include <algorithm>
+#include <cstdint>
+
+namespace cli {
+  namespace {
+    /*
+     * the query of a search, preprocessed for myers' bit-parallel
+     * algorithm: one bit per character of the query, one mask per byte.
+     * each comparison then costs a few word operations per character
+     * of the other string instead of a row of the full table.
+     */
+    class Pattern {
+      public:
+        Pattern(const std::string& str): text(str) {
+          if (text.size() > 64) {
+            return;
+          }
+
+          for (std::size_t i = 0; i < text.size(); ++i) {
+            masks[static_cast<unsigned char>(text[i])] |= (std::uint64_t(1) << i);
+          }
+        }
+
+        std::size_t distance(const std::string& other) const {
+          if (text.size() > 64) {
+            return edit_distance(text, other);
+          }
+
+          if (text.empty()) {
+            return other.size();
+          }
+
+          const std::uint64_t last = std::uint64_t(1) << (text.size() - 1);
+          std::uint64_t positive   = ~std::uint64_t(0);
+          std::uint64_t negative   = 0;
+          std::size_t score        = text.size();
+
+          for (char ch : other) {
+            std::uint64_t equal = masks[static_cast<unsigned char>(ch)];
+            std::uint64_t xv    = equal | negative;
+            std::uint64_t xh    = (((equal & positive) + positive) ^ positive) | equal;
+            std::uint64_t ph    = negative | ~(xh | positive);
+            std::uint64_t mh    = positive & xh;
+
+            if (ph & last) {
+              ++score;
+            }
+            else if (mh & last) {
+              --score;
+            }
+
+            // the first row grows by one per column, hence the carried-in 1
+            ph = (ph << 1) | 1;
+            mh <<= 1;
+
+            positive = mh | ~(xv | ph);
+            negative = ph & xv;
+          }
+
+          return score;
+        }
+
+      private:
+        const std::string& text;
+        std::uint64_t masks[256] = {};
+    };
+  }
+
+  std::size_t edit_distance(const std::string& a, const std::string& b) {
+    std::vector<std::size_t> row(b.size() + 1);
+
+    for (std::size_t j = 0; j <= b.size(); ++j) {
+      row[j] = j;
+    }
+
+    // one row of the table is enough; diagonal holds the cell above-left
+    for (std::size_t i = 1; i <= a.size(); ++i) {
+      std::size_t diagonal = row[0];
+
+      row[0] = i;
+
+      for (std::size_t j = 1; j <= b.size(); ++j) {
+        std::size_t above = row[j];
+
+        row[j] = std::min({ above + 1,
+                            row[j - 1] + 1,
+                            diagonal + (a[i - 1] == b[j - 1] ? 0 : 1) });
+        diagonal = above;
+      }
+    }
+
+    return row[b.size()];
+  }
+
+  BK_Tree::BK_Tree(const BK_Tree& other) {
+    std::lock_guard<std::mutex> lock(other.guard);
+
+    nodes   = other.nodes;
+    pending = other.pending;
+  }
+
+  BK_Tree& BK_Tree::operator=(const BK_Tree& other) {
+    if (this != &other) {
+      std::scoped_lock lock(guard, other.guard);
+
+      nodes   = other.nodes;
+      pending = other.pending;
+    }
+
+    return *this;
+  }
+
+  void BK_Tree::insert(const std::string& key) {
+    pending.push_back(key);
+  }
+
+  void BK_Tree::insert(const std::vector<std::string>& keys) {
+    pending.insert(pending.end(), keys.cbegin(), keys.cend());
+  }
+
+  void BK_Tree::flush() const {
+    for (const std::string& key : pending) {
+      add(key);
+    }
+
+    pending.clear();
+  }
+
+  void BK_Tree::add(const std::string& key) const {
+    if (nodes.empty()) {
+      nodes.push_back(Node{key, {}});
+      return;
+    }
+
+    Pattern pattern(key);
+    std::size_t current = 0;
+
+    while (true) {
+      std::size_t distance = pattern.distance(nodes[current].key);
+
+      if (distance == 0) {
+        return;
+      }
+
+      auto& children = nodes[current].children;
+      auto child     = std::find_if(children.cbegin(), children.cend(),
+          [distance](const std::pair<std::size_t, std::size_t>& edge) {
+            return edge.first == distance;
+          });
+
+      if (child == children.cend()) {
+        children.push_back(std::make_pair(distance, nodes.size()));
+        nodes.push_back(Node{key, {}});
+        return;
+      }
+
+      current = child->second;
+    }
+  }
+
+  std::vector<std::string> BK_Tree::query(const std::string& key,
+                                          std::size_t tolerance) const {
+    std::vector<std::pair<std::size_t, std::size_t>> found; // distance, node
+    std::vector<std::size_t> pending;
+    std::vector<std::string> results;
+    std::lock_guard<std::mutex> lock(guard);
+
+    flush();
+
+    if (nodes.empty()) {
+      return results;
+    }
+
+    Pattern pattern(key);
+
+    pending.push_back(0);
+
+    // by the triangle inequality, only children whose edge lies within
+    // tolerance of the distance to their parent can hold a match
+    while (!pending.empty()) {
+      std::size_t current  = pending.back();
+      std::size_t distance = pattern.distance(nodes[current].key);
+
+      pending.pop_back();
+
+      if (distance <= tolerance) {
+        found.push_back(std::make_pair(distance, current));
+      }
+
+      for (const auto& edge : nodes[current].children) {
+        if (edge.first + tolerance >= distance && edge.first <= distance + tolerance) {
+          pending.push_back(edge.second);
+        }
+      }
+    }
+
+    std::sort(found.begin(), found.end(),
+        [this](const std::pair<std::size_t, std::size_t>& l,
+               const std::pair<std::size_t, std::size_t>& r) {
+          return (l.first != r.first) ? (l.first < r.first)
+                                      : (nodes[l.second].key < nodes[r.second].key);
+        });
+
+    for (const auto& match : found) {
+      results.push_back(nodes[match.second].key);
+    }
+
+    return results;
+  }
+
+  bool BK_Tree::empty() const noexcept {
+    std::lock_guard<std::mutex> lock(guard);
+
+    return nodes.empty() && pending.empty();
+  }
+
+  std::size_t BK_Tree::bytes() const noexcept {
+    std::lock_guard<std::mutex> lock(guard);
+    std::size_t total = nodes.capacity() * sizeof(Node)
+                      + pending.capacity() * sizeof(std::string);
+
+    for (const Node& node : nodes) {
+      total += heap_bytes(node.key)
+             + node.children.capacity() * sizeof(std::pair<std::size_t, std::size_t>);
+    }
+
+    for (const std::string& key : pending) {
+      total += heap_bytes(key);
+    }
+
+    return total;
+  }
+
+  void BK_Tree::clear() noexcept {
+    nodes.clear();
+    pending.clear();
+  }
+}
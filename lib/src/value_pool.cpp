@@ -0,0 +1,51 @@
+/**
+ * \file value_pool.cpp
+ *
+ * \author Adam Marshall (ih8celery)
+ *
+ * \brief set of strings that each get a small, stable id
+ */
+#include "value_pool.h"
+
+namespace cli {
+  std::uint32_t Value_Pool::intern(std::string_view value) {
+    std::size_t hash = Flat_Index::hash(value);
+    std::size_t item = search(value, hash);
+
+    if (item == Flat_Index::npos) {
+      items.emplace_back(value);
+      item = index.add(hash);
+    }
+
+    return static_cast<std::uint32_t>(item);
+  }
+
+  std::optional<std::uint32_t> Value_Pool::find(std::string_view value) const noexcept {
+    std::size_t item = search(value, Flat_Index::hash(value));
+
+    if (item == Flat_Index::npos) {
+      return std::nullopt;
+    }
+
+    return std::make_optional(static_cast<std::uint32_t>(item));
+  }
+
+  const std::string& Value_Pool::value(std::uint32_t id) const noexcept {
+    return items[id];
+  }
+
+  std::size_t Value_Pool::size() const noexcept {
+    return items.size();
+  }
+
+  bool Value_Pool::empty() const noexcept {
+    return items.empty();
+  }
+
+  // the id of value, or Flat_Index::npos
+  std::size_t Value_Pool::search(std::string_view value, std::size_t hash) const noexcept {
+    return index.find(value, hash, [this](std::size_t item) -> std::string_view {
+      return items[item];
+    });
+  }
+}
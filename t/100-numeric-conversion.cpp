@@ -0,0 +1,77 @@
+/**
+ * \file 100-numeric-conversion.cpp
+ * \author Adam Marshall (ih8celery)
+ * \brief test the grammar of integer and float arguments
+ */
+
+#define WANT_TEST_EXTRAS
+#include <tap++.h>
+#include "cmdparse.h"
+#include "convert.h"
+
+using namespace TAP;
+using namespace cli;
+
+int main() {
+  plan(19);
+
+  Command cmd;
+  Info info;
+  std::int64_t integer = 0;
+  double real = 0;
+
+  cmd.option("--limit=i");
+  cmd.option("--mask=i");
+  cmd.option("--size=i");
+  cmd.option("--ratio=f");
+  cmd.option("--ids=[i]");
+
+  char ** args = new char*[5];
+  args[0] = (char*)"--limit=-5";
+  args[1] = (char*)"--mask=0xff";
+  args[2] = (char*)"--size=64M";
+  args[3] = (char*)"--ratio=1e-3";
+  args[4] = (char*)"--ids=0b101,0o17,+3";
+
+  info = cmd.parse(args, 5);
+
+  is(*info.find_integer("limit"), -5, "negative integers accepted");
+  is(*info.find_integer("mask"), 255, "hex prefix accepted");
+  is(*info.find_integer("size"), 64 << 20, "size suffixes are powers of 1024");
+  ok(*info.find_float("ratio") == 1e-3, "exponents accepted");
+  is(info.count("ids"), 3, "prefixed integers accepted in lists");
+  is(*info.find("mask"), "0xff", "original text kept for find");
+  ok(info.find_integers("mask") != nullptr && info.find_integers("mask")->size() == 1,
+      "value kept converted while parsing");
+  ok(!info.find_integer("ratio"), "find_integer fails on non-integers");
+
+  args[0] = (char*)"--limit=9223372036854775808";
+  TRY_NOT_OK(cmd.parse(args, 1), "integer overflow is an error");
+
+  args[0] = (char*)"--size=8589934592G";
+  TRY_NOT_OK(cmd.parse(args, 1), "overflow from a size suffix is an error");
+
+  args[0] = (char*)"--ratio=1e999";
+  TRY_NOT_OK(cmd.parse(args, 1), "float overflow is an error");
+
+  args[0] = (char*)"--ratio=nan";
+  TRY_NOT_OK(cmd.parse(args, 1), "nan is not a float argument");
+
+  args[0] = (char*)"--mask=0x";
+  TRY_NOT_OK(cmd.parse(args, 1), "radix prefix needs digits");
+
+  ok(to_integer("-9223372036854775808", integer) == Conversion::OK
+      && integer == INT64_MIN, "smallest integer converts");
+  ok(to_integer("1.5", integer) == Conversion::BAD_FORMAT, "fractions are not integers");
+  ok(to_integer("--1", integer) == Conversion::BAD_FORMAT, "only one sign allowed");
+  ok(to_integer(" 12 ", integer) == Conversion::OK && integer == 12,
+      "surrounding whitespace ignored");
+  ok(to_float("-.5", real) == Conversion::OK && real == -0.5, "leading dot accepted");
+  ok(to_float("3.14f", real) == Conversion::BAD_FORMAT, "trailing letters rejected");
+
+  delete [] args;
+
+  done_testing();
+
+  return exit_status();
+}
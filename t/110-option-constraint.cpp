@@ -0,0 +1,80 @@
+/**
+ * \file 110-option-constraint.cpp
+ * \author Adam Marshall (ih8celery)
+ * \brief test declared ranges and choices of option arguments
+ */
+
+#define WANT_TEST_EXTRAS
+#include <tap++.h>
+#include "cmdparse.h"
+
+using namespace TAP;
+using namespace cli;
+
+int main() {
+  plan(16);
+
+  Command cmd;
+  Info info;
+
+  cmd.option("--threads=i{1..256}");
+  cmd.option("--mode=s{fast,safe,debug}");
+  cmd.option("--ratio=?f{0..1}");
+  cmd.option("--level={low,high}");
+  cmd.option("--ports=[i{1024..}]");
+  cmd.option("--nice=i{..19}");
+
+  TRY_NOT_OK(cmd.option("--bad=i{1,2}"), "numeric constraints must be ranges");
+  TRY_NOT_OK(cmd.option("--bad=i{9..1}"), "empty ranges are rejected");
+  TRY_NOT_OK(cmd.option("--bad=s{a,,b}"), "choices may not be empty");
+  TRY_NOT_OK(cmd.option("--bad=i{1..2"), "constraint must be closed");
+  TRY_NOT_OK(cmd.option("--bad=i{1..2}{3..4}"), "only one constraint per option");
+
+  char ** args = new char*[6];
+  args[0] = (char*)"--threads=256";
+  args[1] = (char*)"--mode=safe";
+  args[2] = (char*)"--ratio";
+  args[3] = (char*)"0.5";
+  args[4] = (char*)"--ports=8080,0x2000";
+  args[5] = (char*)"--level=low";
+
+  info = cmd.parse(args, 6);
+
+  is(*info.find_integer("threads"), 256, "upper bound is inclusive");
+  is(*info.find("mode"), "safe", "declared choice accepted");
+  ok(*info.find_float("ratio") == 0.5, "float within range accepted");
+  is(info.count("ports"), 2, "list elements within open range accepted");
+  is(*info.find("level"), "low", "choices imply a string argument");
+
+  args[0] = (char*)"--threads=0";
+  TRY_NOT_OK(cmd.parse(args, 1), "integer below range rejected");
+
+  args[0] = (char*)"--mode=slow";
+  TRY_NOT_OK(cmd.parse(args, 1), "undeclared choice rejected");
+
+  args[0] = (char*)"--ratio=1.5";
+  TRY_NOT_OK(cmd.parse(args, 1), "float above range rejected");
+
+  args[0] = (char*)"--ports=8080,80";
+  TRY_NOT_OK(cmd.parse(args, 1), "each list element is checked");
+
+  args[0] = (char*)"--nice=-20";
+  TRY_OK(cmd.parse(args, 1), "lower bound may be omitted");
+
+  try {
+    args[0] = (char*)"--mode=fastest";
+    cmd.parse(args, 1);
+  }
+  catch (parse_error& e) {
+    note(e.what());
+  }
+
+  args[0] = (char*)"--threads=257";
+  TRY_NOT_OK(cmd.parse(args, 1), "integer above range rejected");
+
+  delete [] args;
+
+  done_testing();
+
+  return exit_status();
+}
@@ -0,0 +1,80 @@
+/**
+ * \file 120-collect-errors.cpp
+ * \author Adam Marshall (ih8celery)
+ * \brief test parsing that records every problem instead of throwing
+ */
+
+#define WANT_TEST_EXTRAS
+#include <tap++.h>
+#include "cmdparse.h"
+
+using namespace TAP;
+using namespace cli;
+
+constexpr int ARGC = 8;
+
+int main() {
+  plan(15);
+
+  Command cmd;
+  Info info;
+  Diagnostics diags;
+
+  cmd.option("--age=i{0..150}");
+  cmd.option("--name=s");
+  cmd.option("--ids=[i]");
+  cmd.option("--quiet");
+  cmd.option("-out=!s");
+
+  char ** args = new char*[ARGC];
+  args[0] = (char*)"--age=200";
+  args[1] = (char*)"--bogus";
+  args[2] = (char*)"--name=ann";
+  args[3] = (char*)"--ids=1,x,3,y";
+  args[4] = (char*)"--quiet=yes";
+  args[5] = (char*)"file";
+  args[6] = (char*)"--name=bob";
+  args[7] = (char*)"-out";
+
+  TRY_OK(info = cmd.parse(args, ARGC, diags), "collect mode does not throw");
+
+  is(diags.size(), 7, "every problem recorded");
+  ok(diags[0].code == Error_Code::NOT_IN_RANGE && diags[0].index == 0
+      && diags[0].offset == 6, "range error located at the argument");
+  is(cmd.option_name(diags[0].option), "age", "option id names the option");
+  ok(diags[1].code == Error_Code::UNKNOWN_OPTION && diags[1].option == -1,
+      "unknown option has no id");
+  ok(diags[2].code == Error_Code::BAD_FORMAT && diags[2].offset == 8,
+      "first bad list element located");
+  ok(diags[3].code == Error_Code::BAD_FORMAT && diags[3].offset == 12,
+      "second bad list element located");
+  ok(diags[4].code == Error_Code::UNEXPECTED_ARGUMENT && diags[4].offset == 7,
+      "argument to a flag located at the '='");
+  ok(diags[5].code == Error_Code::REPEATED && diags[5].index == 6,
+      "repeated option reported");
+  ok(diags[6].code == Error_Code::MISSING_ARGUMENT && diags[6].index == 7,
+      "missing argument reported");
+
+  is(*info.find("name"), "ann", "valid options kept");
+  is(info.count("ids"), 2, "valid list elements kept");
+  is(info.rest.size(), 1, "non-options kept");
+
+  args[0] = (char*)"--age=200";
+
+  try {
+    cmd.parse(args, 1);
+    fail("default mode throws");
+  }
+  catch (parse_error& e) {
+    ok(e.code() == Error_Code::NOT_IN_RANGE, "thrown error carries its code");
+  }
+
+  ok(std::string(describe(Error_Code::MISSING_EQUALS)).size() > 0,
+      "error codes have descriptions");
+
+  delete [] args;
+
+  done_testing();
+
+  return exit_status();
+}
@@ -0,0 +1,82 @@
+/**
+ * \file 130-suggestions.cpp
+ * \author Adam Marshall (ih8celery)
+ * \brief test suggestions offered for unknown options
+ */
+
+#define WANT_TEST_EXTRAS
+#include <tap++.h>
+#include "cmdparse.h"
+#include <algorithm>
+
+using namespace TAP;
+using namespace cli;
+
+int main() {
+  plan(10);
+
+  Command cmd;
+  BK_Tree tree;
+  std::vector<std::string> matches;
+
+  is(edit_distance("kitten", "sitting"), 3, "edit distance counts edits");
+  is(edit_distance("", "abc"), 3, "edit distance from empty string");
+
+  tree.insert("book");
+  tree.insert("books");
+  tree.insert("cake");
+  tree.insert("boo");
+  tree.insert("cape");
+  tree.insert("book");
+
+  matches = tree.query("bood", 1);
+  ok(matches.size() == 2 && matches[0] == "boo" && matches[1] == "book",
+      "query finds strings within distance, nearest first");
+  is(tree.query("xyzzy", 1).size(), 0, "no matches for distant strings");
+
+  cmd.option("--verbose");
+  cmd.option("--version");
+  cmd.option("--output=s");
+  cmd.option("-q", "quiet");
+
+  matches = cmd.suggest("--verbse");
+  ok(!matches.empty() && matches[0] == "--verbose", "nearest handle suggested first");
+
+  matches = cmd.suggest("--outptu=file");
+  ok(!matches.empty() && matches[0] == "--output", "argument ignored when suggesting");
+
+  ok(cmd.suggest("--completely-different").empty(), "nothing suggested for distant handles");
+
+  char ** args = new char*[1];
+  args[0] = (char*)"--verison";
+
+  try {
+    cmd.parse(args, 1);
+    fail("unknown option throws");
+  }
+  catch (parse_error& e) {
+    std::string msg = e.what();
+
+    note(msg);
+    ok(msg.find("did you mean --version") != std::string::npos,
+        "error message includes suggestion");
+  }
+
+  cmd.clear();
+  ok(cmd.suggest("--verbse").empty(), "clear empties the suggestion index");
+
+  Command many;
+  for (int i = 0; i < 2000; ++i) {
+    many.option("--option-" + std::to_string(i));
+  }
+
+  matches = many.suggest("--option-1x99");
+  ok(std::find(matches.cbegin(), matches.cend(), "--option-1199") != matches.cend(),
+      "suggestions scale to many handles");
+
+  delete [] args;
+
+  done_testing();
+
+  return exit_status();
+}
@@ -0,0 +1,85 @@
+/**
+ * \file 140-abbreviation.cpp
+ * \author Adam Marshall (ih8celery)
+ * \brief test matching of unique prefixes of handles
+ */
+
+#define WANT_TEST_EXTRAS
+#include <tap++.h>
+#include "cmdparse.h"
+
+using namespace TAP;
+using namespace cli;
+
+int main() {
+  plan(12);
+
+  Command cmd;
+  Info info;
+  Prefix_Index index;
+
+  index.insert("--verbose");
+  index.insert("--version");
+  index.insert("--output");
+  index.insert("--verbose");
+
+  is(index.size(), 3, "index ignores duplicates");
+
+  auto rng = index.range("--ver");
+  is(rng.second - rng.first, 2, "range holds every string with the prefix");
+  ok(index.range("--x").first == index.range("--x").second, "empty range for unknown prefix");
+
+  cmd.option("--verbose|--loud", "verbose");
+  cmd.option("--version");
+  cmd.option("--output=s");
+  cmd.option("--out-of-band");
+  cmd.option("--color|--colour", "color");
+
+  char ** args = new char*[4];
+  args[0] = (char*)"--verb";
+
+  TRY_NOT_OK(cmd.parse(args, 1), "abbreviations are off by default");
+
+  cmd.configure("abbrev");
+
+  args[0] = (char*)"--verb";
+  args[1] = (char*)"--outp=file";
+  args[2] = (char*)"--col";
+  args[3] = (char*)"--version";
+
+  info = cmd.parse(args, 4);
+
+  ok(info.has("verbose"), "unique prefix resolves to its option");
+  is(*info.find("output"), "file", "abbreviation may take an argument");
+  ok(info.has("color"), "prefix shared only by handles of one option is unique");
+  ok(info.has("version"), "exact handle still matched");
+
+  args[0] = (char*)"--ver";
+
+  try {
+    cmd.parse(args, 1);
+    fail("ambiguous abbreviation rejected");
+  }
+  catch (parse_error& e) {
+    note(e.what());
+    ok(e.code() == Error_Code::AMBIGUOUS_OPTION, "ambiguous abbreviation rejected");
+  }
+
+  args[0] = (char*)"--out";
+  TRY_NOT_OK(cmd.parse(args, 1), "prefix of two options is ambiguous");
+
+  args[0] = (char*)"--";
+  args[1] = (char*)"--verb";
+  info = cmd.parse(args, 2);
+  is(info.rest.size(), 1, "end of input stops abbreviation");
+
+  cmd.configure("no_abbrev");
+  args[0] = (char*)"--verb";
+  TRY_NOT_OK(cmd.parse(args, 1), "abbreviations can be turned off");
+
+  delete [] args;
+
+  done_testing();
+
+  return exit_status();
+}
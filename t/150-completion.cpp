@@ -0,0 +1,77 @@
+/**
+ * \file 150-completion.cpp
+ * \author Adam Marshall (ih8celery)
+ * \brief test completion of partial command lines
+ */
+
+#define WANT_TEST_EXTRAS
+#include <tap++.h>
+#include "cmdparse.h"
+#include <sstream>
+
+using namespace TAP;
+using namespace cli;
+
+int main() {
+  plan(12);
+
+  Command cmd;
+  std::vector<std::string> matches;
+
+  cmd.option("--verbose");
+  cmd.option("--version");
+  cmd.option("--color={auto,always,never}");
+
+  auto remote = cmd.command("remote");
+  auto reset  = cmd.command("reset");
+  auto add    = remote->command("add");
+
+  add->option("--fetch");
+  add->option("--mirror=!s{fetch,push}");
+
+  const char * line[] = { "re" };
+  matches = cmd.complete(line, 1, 0);
+  ok(matches.size() == 2 && matches[0] == "remote" && matches[1] == "reset",
+      "subcommand names completed");
+
+  const char * nested[] = { "remote", "a" };
+  matches = cmd.complete(nested, 2, 1);
+  ok(matches.size() == 1 && matches[0] == "add", "nested subcommand names completed");
+
+  const char * handles[] = { "remote", "add", "--" };
+  matches = cmd.complete(handles, 3, 2);
+  is(matches.size(), 5, "handles of the subcommand and its parents offered");
+  ok(matches.front() == "--color" && matches.back() == "--version", "handles sorted");
+
+  const char * prefix[] = { "remote", "add", "--f" };
+  matches = cmd.complete(prefix, 3, 2);
+  ok(matches.size() == 1 && matches[0] == "--fetch", "handles filtered by prefix");
+
+  const char * choice[] = { "remote", "add", "--mirror", "p" };
+  matches = cmd.complete(choice, 4, 3);
+  ok(matches.size() == 1 && matches[0] == "push", "separate argument completed from choices");
+
+  const char * eq[] = { "remote", "add", "--color=a" };
+  matches = cmd.complete(eq, 3, 2);
+  ok(matches.size() == 2 && matches[0] == "--color=always" && matches[1] == "--color=auto",
+      "argument after '=' completed from choices of a parent option");
+
+  const char * fresh[] = { "reset" };
+  matches = cmd.complete(fresh, 1, 1);
+  is(matches.size(), 3, "new word after a leaf subcommand offers handles");
+
+  const char * done[] = { "reset", "--", "--v" };
+  ok(cmd.complete(done, 3, 2).empty(), "nothing completed after end of input");
+
+  const char * request[] = { "prog", "--__complete", "2", "remote", "add", "--m" };
+  std::ostringstream out;
+  ok(cmd.serve_completion(6, request, out), "completion request recognized");
+  is(out.str(), "--mirror\n", "matches written one per line");
+
+  const char * normal[] = { "prog", "remote", "add" };
+  ok(!cmd.serve_completion(3, normal, out), "other command lines ignored");
+
+  done_testing();
+
+  return exit_status();
+}
@@ -0,0 +1,230 @@
+/**
+ * \file 160-session.cpp
+ * \author Adam Marshall (ih8celery)
+ * \brief test incremental parsing of a line being edited
+ */
+
+#define WANT_TEST_EXTRAS
+#include <tap++.h>
+#include "session.h"
+#include <sstream>
+
+using namespace TAP;
+using namespace cli;
+
+// the tokens of an edited line should match those of a fresh parse
+bool same_as_fresh(const Command& cmd, const Session& session) {
+  Session fresh(cmd, session.line());
+  const std::vector<Token>& l = session.tokens();
+  const std::vector<Token>& r = fresh.tokens();
+
+  if (l.size() != r.size()) {
+    return false;
+  }
+
+  for (std::size_t i = 0; i < l.size(); ++i) {
+    if (l[i].offset != r[i].offset || l[i].length != r[i].length
+        || l[i].kind != r[i].kind || l[i].error != r[i].error
+        || l[i].error_offset != r[i].error_offset || l[i].option != r[i].option) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// each word should have the first problem that parse finds in it
+bool same_as_parse(const Command& cmd, const std::string& line) {
+  Session session(cmd, line);
+  Diagnostics diags;
+  std::vector<std::string> words;
+  std::vector<const char *> args;
+  std::istringstream in(line);
+
+  for (std::string word; in >> word;) {
+    words.push_back(word);
+  }
+
+  for (const std::string& word : words) {
+    args.push_back(word.c_str());
+  }
+
+  cmd.parse(args.data(), (int)args.size(), diags);
+
+  // a session gives one problem per word, and UNKNOWN_COMMAND besides
+  Diagnostics first;
+
+  for (const Diagnostic& diag : diags) {
+    if (first.empty() || first.back().index != diag.index
+        || first.back().code == Error_Code::UNKNOWN_COMMAND) {
+      first.push_back(diag);
+    }
+  }
+
+  Diagnostics found = session.diagnostics();
+
+  if (found.size() != first.size()) {
+    return false;
+  }
+
+  for (std::size_t i = 0; i < found.size(); ++i) {
+    if (found[i].code != first[i].code || found[i].offset != first[i].offset
+        || found[i].index != first[i].index || found[i].option != first[i].option) {
+      return false;
+    }
+  }
+
+  const std::vector<Token>& tokens = session.tokens();
+  std::size_t next = 0;
+
+  if (tokens.size() != words.size()) {
+    return false;
+  }
+
+  for (std::size_t i = 0; i < tokens.size(); ++i) {
+    Error_Code expected  = Error_Code::NONE;
+    std::uint32_t offset = 0;
+
+    if (next < diags.size() && diags[next].index == (std::int32_t)i) {
+      expected = diags[next].code;
+      offset   = diags[next].offset;
+    }
+
+    while (next < diags.size() && diags[next].index == (std::int32_t)i) {
+      ++next;
+    }
+
+    if (tokens[i].error != expected || tokens[i].error_offset != offset) {
+      return false;
+    }
+  }
+
+  // only a missing subcommand is found past the last word
+  return (next == diags.size()
+          || (next + 1 == diags.size() && diags[next].index == (std::int32_t)tokens.size()));
+}
+
+int main() {
+  plan(31);
+
+  Command cmd;
+  std::vector<std::size_t> changed;
+
+  cmd.option("--verbose?", "verbose");
+  cmd.option("--level=i{0..9}", "level");
+  cmd.option("--out=!s", "out");
+  cmd.option("--tags=[s]", "tags");
+
+  Session session(cmd, "--verbose --level=3 file");
+
+  is(session.tokens().size(), 3, "line split into words");
+  ok(session.tokens()[0].kind == Token_Kind::OPTION
+      && session.tokens()[1].kind == Token_Kind::OPTION
+      && session.tokens()[2].kind == Token_Kind::POSITIONAL, "words classified");
+  ok(session.diagnostics().empty(), "valid line has no diagnostics");
+
+  changed = session.edit(18, 1, "12");
+  ok(changed.size() == 1 && changed[0] == 1, "only the edited word reported");
+  ok(session.tokens()[1].error == Error_Code::NOT_IN_RANGE
+      && session.tokens()[1].error_offset == 8, "argument checked after edit");
+  is(session.tokens()[2].offset, 21, "later words shifted");
+
+  changed = session.edit(18, 2, "4");
+  ok(changed.size() == 1 && session.tokens()[1].error == Error_Code::NONE,
+      "error cleared by edit");
+
+  changed = session.edit(session.line().size(), 0, " --out");
+  ok(changed.back() == 3 && session.tokens()[3].error == Error_Code::MISSING_ARGUMENT,
+      "option at end of line lacks its argument");
+
+  changed = session.edit(session.line().size(), 0, " log");
+  ok(changed.size() == 2 && session.tokens()[3].error == Error_Code::NONE
+      && session.tokens()[4].kind == Token_Kind::ARGUMENT, "typing the argument fixes the option");
+
+  changed = session.edit(0, 0, "--verbose ");
+  ok(session.tokens()[1].error == Error_Code::REPEATED && session.diagnostics().size() == 1,
+      "repeat found after inserting a word before it");
+  ok(same_as_fresh(cmd, session), "edited line matches a fresh parse");
+
+  // deleting the space joins the option to its argument
+  changed = session.edit(session.line().find(" log"), 1, "");
+  ok(session.line() == "--verbose --verbose --level=4 file --outlog", "words joined");
+  ok(session.tokens().back().error == Error_Code::UNKNOWN_OPTION, "joined word reclassified");
+  ok(same_as_fresh(cmd, session), "joined line matches a fresh parse");
+
+  session.edit(0, 10, "");
+  changed = session.edit(session.line().size(), 0, " --tags=a,,b --bogus");
+  ok(session.tokens().back().error == Error_Code::UNKNOWN_OPTION, "unknown option flagged");
+
+  Token last = session.token(session.size() - 1);
+
+  ok(session.size() == session.tokens().size()
+      && last.offset == session.tokens().back().offset
+      && last.error == session.tokens().back().error, "one token read without the rest");
+
+  Session copy(session);
+
+  ok(copy.line() == session.line() && same_as_fresh(cmd, copy), "copy holds the same parse");
+
+  // many edits spread over a longer line, each joining or splitting words
+  std::string words[] = { "--verbose", "--level=", "7", " ", "--out", "x", "-", "--tags=a" };
+
+  for (std::size_t i = 0; i < 200; ++i) {
+    std::size_t size = session.line().size();
+
+    session.edit((i * 7919) % (size + 1), i % 3, words[i % 8]);
+  }
+
+  ok(same_as_fresh(cmd, session), "line edited many times matches a fresh parse");
+
+  ok(same_as_parse(cmd, "--level=3 --level=x"), "repeat found before a bad argument");
+  ok(same_as_parse(cmd, "--level=3 --level"), "repeat found before a missing equals");
+  ok(same_as_parse(cmd, "--verbose --out a --out --verbose"),
+      "repeated option does not take the next word");
+  ok(same_as_parse(cmd, "--tags=a,,b --tags=a,b"), "partly kept list counts as given");
+  ok(same_as_parse(cmd, "--level=x --level=3 --out --bad --out x"),
+      "rejected arguments do not count as given");
+
+  Command late;
+
+  late.option("--mode*=!s{fast,slow}", "mode");
+
+  ok(same_as_parse(late, "--mode fast --mode bogus --mode"),
+      "repeat of a scalar found at its argument");
+
+  Command tool;
+
+  tool.option("-D*=&s", "define");
+  tool.option("--level=i{0..9}", "level");
+  tool.command("build");
+
+  ok(same_as_parse(tool, "-Dfoo --level=3"), "option in place of a subcommand");
+  ok(same_as_parse(tool, "--level=12 -Dx"), "problem of an option in place of a subcommand");
+  ok(same_as_parse(tool, "build -Dx"), "subcommand found");
+
+  Command named("git");
+
+  named.option("--level=i{0..9}", "level");
+
+  ok(same_as_parse(named, "gut --level=12 --bogus"), "nothing read after a wrong name");
+  ok(same_as_parse(named, "git --level=12 --bogus"), "words read after the name");
+
+  named.command("push");
+
+  ok(same_as_parse(named, "git"), "subcommand missing after the name");
+
+  Command git;
+  auto remote = git.command("remote");
+
+  remote->option("--fetch");
+
+  Session nested(git, "remote --fetch");
+  nested.edit(0, 6, "remove");
+  ok(nested.tokens()[0].error == Error_Code::UNKNOWN_COMMAND
+      && nested.tokens()[1].error == Error_Code::UNKNOWN_OPTION,
+      "editing the subcommand rematches the words after it");
+
+  done_testing();
+
+  return exit_status();
+}
@@ -0,0 +1,92 @@
+/**
+ * \file 170-pattern-handles.cpp
+ * \author Adam Marshall (ih8celery)
+ * \brief test prefix handles and negated flags
+ */
+
+#define WANT_TEST_EXTRAS
+#include <tap++.h>
+#include "cmdparse.h"
+#include <string>
+#include <vector>
+
+using namespace TAP;
+using namespace cli;
+
+int main() {
+  plan(14);
+
+  Command cmd;
+  Info info;
+
+  cmd.option("-D|--define-*=&s", "define");
+  cmd.option("-I*=&[s]", "include");
+  cmd.option("-O=&i{0..3}", "optimize");
+  cmd.option("--color!");
+  cmd.option("-S=|s", "stuck");
+
+  TRY_NOT_OK(cmd.option("X=&s", "bare"), "prefix handles must have a prefix");
+  TRY_NOT_OK(cmd.option("--quiet!=s"), "only a flag may be negated");
+
+  const char * args[] = { "-DNAME=value", "--define-DEBUG", "-Iinclude,src",
+                          "-O2", "--color", "-Sx" };
+  std::vector<char *> argv;
+
+  for (const char * arg : args) {
+    argv.push_back(const_cast<char *>(arg));
+  }
+
+  info = cmd.parse(argv.data(), argv.size());
+
+  is(info.count("define"), 2, "prefix family repeats");
+  ok(*info.find("define") == "NAME=value" || *info.find("define") == "DEBUG",
+      "argument is the rest of the word, '=' included");
+  is(info.count("include"), 2, "prefix handle with a list");
+  ok(info.has("optimize") && info.has("color"), "single prefix handle and flag found");
+  ok(*info.find("stuck") == "x", "stuck handles resolved the same way");
+
+  char * bad[] = { (char*)"-O7" };
+  TRY_NOT_OK(cmd.parse(bad, 1), "prefix argument checked against its range");
+
+  char * missing[] = { (char*)"-O" };
+  TRY_NOT_OK(cmd.parse(missing, 1), "prefix handle alone lacks an argument");
+
+  char * twice[] = { (char*)"-O1", (char*)"-O2" };
+  TRY_NOT_OK(cmd.parse(twice, 2), "prefix handle without '*' may not repeat");
+
+  char * negated[] = { (char*)"--color", (char*)"--no-color" };
+  info = cmd.parse(negated, 2);
+  ok(!info.has("color"), "negated flag cleared");
+
+  char * again[] = { (char*)"--no-color", (char*)"--color" };
+  info = cmd.parse(again, 2);
+  ok(info.has("color"), "flag after its negation set");
+
+  // exact handles still win over prefix handles
+  Command exact;
+  exact.option("-D*=&s", "define");
+  exact.option("-Debug", "debug");
+
+  char * both[] = { (char*)"-Debug", (char*)"-Dx" };
+  info = exact.parse(both, 2);
+  ok(info.has("debug") && *info.find("define") == "x", "exact match tried first");
+
+  // many prefix flags; each is one hash miss and one walk down the trie
+  std::vector<std::string> storage;
+  std::vector<char *> many;
+
+  for (int i = 0; i < 10000; ++i) {
+    storage.push_back("-DFLAG_" + std::to_string(i));
+  }
+
+  for (std::string& arg : storage) {
+    many.push_back(&arg[0]);
+  }
+
+  info = cmd.parse(many.data(), many.size());
+  is(info.count("define"), 10000, "thousands of prefix flags parsed");
+
+  done_testing();
+
+  return exit_status();
+}
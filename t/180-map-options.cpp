@@ -0,0 +1,85 @@
+/**
+ * \file 180-map-options.cpp
+ * \author Adam Marshall (ih8celery)
+ * \brief test options collecting keys and values into a map
+ */
+
+#define WANT_TEST_EXTRAS
+#include <tap++.h>
+#include "cmdparse.h"
+#include <string>
+#include <vector>
+
+using namespace TAP;
+using namespace cli;
+
+int main() {
+  plan(15);
+
+  Command cmd;
+  Info info;
+
+  cmd.option("--set*={s:i}", "set");
+  cmd.option("-D*=&{s:s}", "define");
+  cmd.option("--env*=!{s:s?}", "env");
+  cmd.option("--port*={i:s!}", "port");
+  cmd.option("--mode={fast,safe}", "mode");
+
+  TRY_NOT_OK(cmd.option("--bad={s:i", "bad"), "map must be closed");
+
+  char * argv[] = { (char*)"--set=width=80", (char*)"--set=height=24",
+                    (char*)"--set=width=100", (char*)"-DDEBUG", (char*)"-DLEVEL=2",
+                    (char*)"--env", (char*)"HOME=/root", (char*)"--env", (char*)"HOME=/tmp",
+                    (char*)"--mode=safe" };
+
+  info = cmd.parse(argv, 10);
+
+  ok(info.has("set") && info.count("set") == 2, "keys counted once each");
+  ok(info.lookup("set", "width") == std::string_view("100"), "later value wins by default");
+  ok(info.lookup("set", "height") == std::string_view("24"), "value looked up by key");
+  ok(!info.lookup("set", "depth"), "missing key not found");
+  ok(info.lookup("define", "DEBUG") == std::string_view(""), "string value may be left out");
+  ok(info.lookup("define", "LEVEL") == std::string_view("2"), "prefix handle with a map");
+  ok(info.lookup("env", "HOME") == std::string_view("/root"), "'?' keeps the first value");
+  ok(info.lookup("mode", "safe") == std::nullopt && info.find("mode") == std::string("safe"),
+      "choices are not mistaken for a map");
+
+  const Flat_Map * set = info.find_map("set");
+  ok(set != nullptr && set->entries()[0].first == "width"
+      && set->entries()[1].first == "height", "entries kept in order of first insertion");
+
+  char * bad_value[] = { (char*)"--set=width=wide" };
+  TRY_NOT_OK(cmd.parse(bad_value, 1), "value checked against its type");
+
+  char * bad_key[] = { (char*)"--port=http=80" };
+  TRY_NOT_OK(cmd.parse(bad_key, 1), "key checked against its type");
+
+  char * duplicate[] = { (char*)"--port=80=http", (char*)"--port=80=www" };
+  Diagnostics diags;
+  cmd.parse(duplicate, 2, diags);
+  ok(diags.size() == 1 && diags[0].code == Error_Code::DUPLICATE_KEY && diags[0].index == 1,
+      "'!' rejects a repeated key");
+
+  char * no_value[] = { (char*)"--set=width" };
+  TRY_NOT_OK(cmd.parse(no_value, 1), "integer value may not be left out");
+
+  // many keys; the map grows and keeps every one
+  std::vector<std::string> storage;
+  std::vector<char *> many;
+
+  for (int i = 0; i < 5000; ++i) {
+    storage.push_back("-DKEY_" + std::to_string(i) + "=" + std::to_string(i));
+  }
+
+  for (std::string& arg : storage) {
+    many.push_back(&arg[0]);
+  }
+
+  info = cmd.parse(many.data(), many.size());
+  ok(info.count("define") == 5000 && info.lookup("define", "KEY_4321") == std::string_view("4321"),
+      "thousands of keys stored");
+
+  done_testing();
+
+  return exit_status();
+}
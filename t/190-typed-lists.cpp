@@ -0,0 +1,75 @@
+/**
+ * \file 190-typed-lists.cpp
+ * \author Adam Marshall (ih8celery)
+ * \brief test numeric lists kept in typed vectors
+ */
+
+#define WANT_TEST_EXTRAS
+#include <tap++.h>
+#include "cmdparse.h"
+#include <string>
+
+using namespace TAP;
+using namespace cli;
+
+int main() {
+  plan(12);
+
+  Command cmd;
+  Info info;
+
+  cmd.option("--ids=[i]", "ids");
+  cmd.option("--weights=[f{0..1}]", "weights");
+
+  char * argv[] = { (char*)"--ids=0x10,2,-3", (char*)"--weights=0.5,.25" };
+
+  info = cmd.parse(argv, 2);
+
+  const std::vector<std::int64_t> * ids = info.find_integers("ids");
+  const std::vector<double> * weights   = info.find_floats("weights");
+
+  ok(ids != nullptr && *ids == std::vector<std::int64_t>({ 16, 2, -3 }),
+      "integers converted into one vector");
+  ok(weights != nullptr && weights->size() == 2 && (*weights)[1] == 0.25,
+      "floats converted into one vector");
+  ok(info.find("ids") == std::string("0x10")
+      && *info.find_all("ids") == std::vector<std::string>({ "0x10", "2", "-3" }),
+      "elements also given as they were written");
+  ok(info.find_integer("ids") == 16 && info.find_float("weights") == 0.5,
+      "first element found by type");
+
+  char * empty[] = { (char*)"--ids=" };
+  info = cmd.parse(empty, 1);
+  ok(!info.has("ids") && info.find_integers("ids") == nullptr, "empty list holds nothing");
+
+  std::string huge = "--ids=";
+
+  for (int i = 0; i < 200000; ++i) {
+    huge += std::to_string(i);
+    huge += (i == 1000 || i == 150000) ? "x," : ",";
+  }
+
+  char * big[] = { &huge[0] };
+  Diagnostics diags;
+
+  info = cmd.parse(big, 1, diags);
+  ids  = info.find_integers("ids");
+
+  is(info.count("ids"), 199998, "valid elements of a long list kept");
+  ok(ids != nullptr && (*ids)[1000] == 1001 && (*ids)[149998] == 149999,
+      "elements of a long list kept in order");
+  is(diags.size(), 2, "every bad element reported");
+  ok(diags.size() == 2 && diags[0].offset < diags[1].offset, "problems reported in order");
+  ok(diags.size() == 2 && huge.compare(diags[1].offset, 7, "150000x") == 0,
+      "offset points at the bad element");
+
+  big[0] = &huge[0];
+  TRY_NOT_OK(cmd.parse(big, 1), "first bad element of a long list throws");
+
+  char * range[] = { (char*)"--weights=0.5,2" };
+  TRY_NOT_OK(cmd.parse(range, 1), "range checked for each element");
+
+  done_testing();
+
+  return exit_status();
+}
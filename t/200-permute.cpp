@@ -0,0 +1,69 @@
+/**
+ * \file 200-permute.cpp
+ * \author Adam Marshall (ih8celery)
+ * \brief test parsing a const argv and permuting the words left over
+ */
+
+#define WANT_TEST_EXTRAS
+#include <tap++.h>
+#include "cmdparse.h"
+#include <cstring>
+
+using namespace TAP;
+using namespace cli;
+
+int main() {
+  plan(12);
+
+  Command cmd;
+  Info info;
+  Diagnostics diags;
+
+  cmd.option("-v?", "verbose");
+  cmd.option("--out=?s", "out");
+
+  const char * words[] = { "a.c", "-v", "--out", "x", "b.c", "" };
+  Info cinfo = cmd.parse(words, 5);
+
+  ok(cinfo.has("verbose") && cinfo.find("out") == "x", "const argv parsed");
+  ok(std::strcmp(words[1], "-v") == 0 && std::strcmp(words[3], "x") == 0,
+      "const argv untouched");
+  is(cinfo.rest.size(), 2, "positionals kept in rest");
+
+  char a0[] = "a.c", a1[] = "-v", a2[] = "--out", a3[] = "x", a4[] = "b.c";
+  char a5[] = "", a6[] = "--", a7[] = "-c";
+  char * argv[] = { a0, a1, a2, a3, a4, a5, a6, a7 };
+
+  int argc = cmd.permute(argv, 8, info);
+
+  is(argc, 3, "unconsumed words counted");
+  ok(argv[0] == a0 && argv[1] == a4 && argv[2] == a5, "unconsumed words moved to front in order");
+  ok(info.has("verbose") && info.find("out") == "x", "options parsed while permuting");
+  is(info.rest.size(), 3, "words after -- go to rest");
+  is(info.rest.back(), "-c", "words after -- kept as given");
+
+  char b0[] = "-v", b1[] = "-v", b2[] = "f";
+  char * bad[] = { b0, b1, b2 };
+
+  Info again;
+
+  argc = cmd.permute(bad, 3, again, diags);
+  is(argc, 1, "permute with diagnostics still compacts");
+  ok(bad[0] == b2, "positional moved to front");
+  is(diags.size(), 1, "repeat reported");
+
+  char * none[] = { a2 };
+
+  try {
+    Info missing;
+    cmd.permute(none, 1, missing);
+    fail("missing argument throws without diagnostics");
+  }
+  catch (parse_error& e) {
+    pass("missing argument throws without diagnostics");
+  }
+
+  done_testing();
+
+  return exit_status();
+}
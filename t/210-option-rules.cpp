@@ -0,0 +1,150 @@
+/**
+ * \file 210-option-rules.cpp
+ * \author Adam Marshall (ih8celery)
+ * \brief test constraints between options: required, depends, conflicts
+ */
+
+#define WANT_TEST_EXTRAS
+#include <tap++.h>
+#include "cmdparse.h"
+
+using namespace TAP;
+using namespace cli;
+
+int main() {
+  plan(17);
+
+  Command cmd;
+  Diagnostics diags;
+  char * args[4];
+
+  cmd.option("--user=s", "user");
+  cmd.option("--password=s", "password");
+  cmd.option("--quiet", "quiet");
+  cmd.option("--verbose", "verbose");
+  cmd.option("--json", "json");
+  cmd.option("--yaml", "yaml");
+  cmd.option("--no-color", "plain");
+
+  cmd.required("user");
+  cmd.depends("password", { "user" });
+  cmd.conflicts("quiet", { "verbose" });
+  cmd.exactly_one({ "json", "yaml" });
+
+  try {
+    cmd.depends("password", { "token" });
+    fail("undeclared option in constraint throws");
+  }
+  catch (option_language_error& e) {
+    pass("undeclared option in constraint throws");
+  }
+
+  args[0] = (char*)"--user=me";
+  args[1] = (char*)"--json";
+  cmd.parse(args, 2, diags);
+  ok(diags.empty(), "constraints satisfied");
+
+  args[0] = (char*)"--json";
+  cmd.parse(args, 1, diags);
+  is(diags.size(), 1, "missing required option found");
+  ok(diags[0].code == Error_Code::MISSING_REQUIRED && diags[0].index == 1
+      && diags[0].option == -1, "missing option reported past the end");
+
+  diags.clear();
+  args[0] = (char*)"--user=me";
+  args[1] = (char*)"--yaml";
+  args[2] = (char*)"--verbose";
+  args[3] = (char*)"--quiet";
+  cmd.parse(args, 4, diags);
+  ok(diags.size() == 1 && diags[0].code == Error_Code::CONFLICTING_OPTIONS,
+      "conflict found");
+  is(diags[0].index, 3, "conflict reported at the later option");
+
+  diags.clear();
+  args[0] = (char*)"--password=x";
+  args[1] = (char*)"--json";
+  args[2] = (char*)"--yaml";
+  cmd.parse(args, 3, diags);
+  is(diags.size(), 3, "every broken constraint reported");
+  ok(diags[0].code == Error_Code::MISSING_REQUIRED
+      && diags[1].code == Error_Code::MISSING_DEPENDENCY && diags[1].index == 0,
+      "dependency reported at the dependent option");
+  ok(diags[2].code == Error_Code::CONFLICTING_OPTIONS && diags[2].index == 2
+      && diags[2].option == 5, "second of an exclusive group reported");
+
+  diags.clear();
+  args[0] = (char*)"--user=me";
+  cmd.parse(args, 1, diags);
+  ok(diags.size() == 1 && diags[0].code == Error_Code::MISSING_REQUIRED,
+      "empty exclusive group is missing");
+
+  try {
+    args[0] = (char*)"--user=me";
+    args[1] = (char*)"--json";
+    args[2] = (char*)"--verbose";
+    args[3] = (char*)"--quiet";
+    cmd.parse(args, 4);
+    fail("conflict throws without diagnostics");
+  }
+  catch (parse_error& e) {
+    ok(e.code() == Error_Code::CONFLICTING_OPTIONS, "conflict throws without diagnostics");
+  }
+
+  // options whose values were rejected are not present
+  Command strict;
+
+  strict.option("--level=i{0..9}", "level");
+  strict.option("--a=i", "a");
+  strict.option("--b", "b");
+  strict.required("level");
+  strict.conflicts("a", { "b" });
+
+  args[0] = (char*)"--level=x";
+  strict.parse(args, 1, diags = Diagnostics());
+  ok(diags.size() == 2 && diags[1].code == Error_Code::MISSING_REQUIRED,
+      "rejected value does not meet required");
+
+  args[0] = (char*)"--level=3";
+  args[1] = (char*)"--a=one";
+  args[2] = (char*)"--b";
+  strict.parse(args, 3, diags = Diagnostics());
+  ok(diags.size() == 1 && diags[0].code == Error_Code::BAD_FORMAT,
+      "rejected value conflicts with nothing");
+
+  args[0] = (char*)"--level=3";
+  args[1] = (char*)"--a=1";
+  args[2] = (char*)"--b=yes";
+  strict.parse(args, 3, diags = Diagnostics());
+  ok(diags.size() == 1 && diags[0].code == Error_Code::UNEXPECTED_ARGUMENT,
+      "flag given an argument conflicts with nothing");
+
+  // ids past the first word of the bitset
+  Command wide;
+
+  for (int i = 0; i < 130; ++i) {
+    wide.option("--o" + std::to_string(i), "o" + std::to_string(i));
+  }
+
+  wide.at_least_one({ "o1", "o129" });
+  wide.conflicts("o0", { "o128" });
+
+  args[0] = (char*)"--o129";
+  args[1] = (char*)"--o0";
+  wide.parse(args, 2, diags = Diagnostics());
+  ok(diags.empty(), "group spanning words satisfied");
+
+  args[0] = (char*)"--o128";
+  args[1] = (char*)"--o0";
+  wide.parse(args, 2, diags);
+  ok(diags.size() == 2 && diags[0].code == Error_Code::MISSING_REQUIRED
+      && diags[1].code == Error_Code::CONFLICTING_OPTIONS, "rules over high ids checked");
+
+  wide.clear();
+  wide.option("--o0", "o0");
+  args[0] = (char*)"--o0";
+  ok(wide.parse(args, 1).has("o0"), "clear drops constraints");
+
+  done_testing();
+
+  return exit_status();
+}
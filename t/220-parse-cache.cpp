@@ -0,0 +1,87 @@
+/**
+ * \file 220-parse-cache.cpp
+ * \author Adam Marshall (ih8celery)
+ * \brief test caching the parses of repeated command lines
+ */
+
+#define WANT_TEST_EXTRAS
+#include <tap++.h>
+#include "parse_cache.h"
+
+using namespace TAP;
+using namespace cli;
+
+int main() {
+  plan(14);
+
+  Command cmd;
+  Parse_Cache cache(cmd, 2);
+
+  cmd.option("--out=s", "out");
+  cmd.option("-v", "verbose");
+
+  const char * first[]  = { "--out=a", "-v" };
+  const char * second[] = { "--out=b" };
+  const char * joined[] = { "--out=a-v" };
+  const char * third[]  = { "-v" };
+
+  auto info = cache.parse(first, 2);
+  ok(info->has("verbose") && info->find("out") == "a", "first parse");
+  ok(cache.parse(first, 2) == info && cache.hits() == 1 && cache.misses() == 1,
+      "repeated words answered from the cache");
+  ok(cache.parse(joined, 1)->find("out") == "a-v", "words told apart by boundaries");
+  is(cache.size(), 2, "entries counted");
+
+  cache.parse(first, 2);
+  cache.parse(second, 1);
+  is(cache.size(), 2, "size bounded");
+  ok(cache.parse(first, 2) == info, "recently used entry kept");
+  is(cache.misses(), 3, "least recently used entry was dropped");
+  cache.parse(joined, 1);
+  is(cache.misses(), 4, "dropped entry parsed again");
+
+  try {
+    const char * bad[] = { "--out" };
+    cache.parse(bad, 1);
+    fail("failed parse throws");
+  }
+  catch (parse_error& e) {
+    pass("failed parse throws");
+  }
+
+  is(cache.size(), 2, "failed parse not cached");
+
+  cmd.option("--verbose", "verbose");
+  ok(cache.parse(first, 2) != info && cache.size() == 1, "option() empties the cache");
+
+  Command git;
+  auto run = git.command("run");
+  Parse_Cache nested(git);
+  const char * words[] = { "run", "-x" };
+
+  run->option("-x");
+  info = nested.parse(words, 2);
+  run->option("-y");
+  ok(nested.parse(words, 2) != info, "changing a subcommand empties the cache");
+
+  // clear() drops the subcommand and its changes with it
+  Command remote;
+  auto sub = remote.command("sub");
+  Parse_Cache redeclared(remote);
+  const char * subwords[] = { "sub", "--x" };
+
+  sub->option("--x");
+  sub->option("--y");
+  redeclared.parse(subwords, 2);
+  remote.clear();
+  remote.option("--b");
+  TRY_NOT_OK(redeclared.parse(subwords, 2), "clear() and redeclaring empty the cache");
+
+  Parse_Cache none(cmd, 0);
+  none.parse(third, 1);
+  ok(none.size() == 0 && none.misses() == 1, "zero capacity caches nothing");
+
+  done_testing();
+
+  return exit_status();
+}
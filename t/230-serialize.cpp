@@ -0,0 +1,76 @@
+/**
+ * \file 230-serialize.cpp
+ * \author Adam Marshall (ih8celery)
+ * \brief test the flat layout of Info read back in place and rebuilt
+ */
+
+#define WANT_TEST_EXTRAS
+#include <tap++.h>
+#include "cmdparse.h"
+#include "info_view.h"
+#include <stdexcept>
+
+using namespace TAP;
+using namespace cli;
+
+int main() {
+  plan(16);
+
+  Command cmd;
+
+  cmd.option("-v", "verbose");
+  cmd.option("--inc=[s]", "include");
+  cmd.option("--set*={s:s}", "set");
+  cmd.option("--nums=[i]", "nums");
+  cmd.option("--scale=[f]", "scale");
+
+  const char * args[] = { "--inc=a,b", "-v", "--set=x=1", "--set=a=2",
+                          "--nums=0x1,2,3", "--scale=0.5", "file", "--", "-z" };
+  Info info = cmd.parse(args, 9);
+
+  std::string bytes = info.serialize();
+  Info_View view(bytes.data(), bytes.size());
+
+  is(view.size(), bytes.size(), "view covers the buffer");
+  ok(view.has("verbose") && view.has("set") && !view.has("bogus"), "names found");
+  ok(view.find("include") == info.find("include"), "first value read in place");
+
+  auto all = view.find_all("include");
+  ok(all.size() == 2 && all[0] == "a" && all[1] == "b", "every value read in order");
+  ok(view.lookup("set", "a") == "2" && view.lookup("set", "x") == "1"
+      && !view.lookup("set", "y"), "map keys found");
+
+  auto nums = view.find_integers("nums");
+  ok(nums.size() == 3 && nums[2] == 3, "integers read in place");
+  ok(view.find_floats("scale").size() == 1 && view.find_floats("scale")[0] == 0.5,
+      "floats read in place");
+  ok(view.find_integers("scale").empty(), "wrong type gives an empty view");
+  ok(view.find("nums") == "0x1" && view.find_all("nums").size() == 3,
+      "numbers read as they were written");
+  is(view.count("set"), 2, "map keys counted");
+  ok(view.rest_size() == 2 && view.rest(0) == "file" && view.rest(1) == "-z", "rest kept");
+
+  Info copy = Info::deserialize(bytes.data(), bytes.size());
+  ok(copy.find_all("include") == info.find_all("include") && copy.has("verbose"),
+      "values rebuilt");
+  ok(copy.find_map("set")->entries() == info.find_map("set")->entries(),
+      "map rebuilt in order");
+  ok(*copy.find_integers("nums") == *info.find_integers("nums")
+      && copy.find_all("nums") == info.find_all("nums") && copy.rest == info.rest,
+      "lists and rest rebuilt");
+
+  try {
+    Info_View bad(bytes.data(), 8);
+    fail("short buffer rejected");
+  }
+  catch (std::invalid_argument& e) {
+    pass("short buffer rejected");
+  }
+
+  std::string empty = Info().serialize();
+  ok(!Info_View(empty.data(), empty.size()).has("verbose"), "empty Info serialized");
+
+  done_testing();
+
+  return exit_status();
+}
@@ -0,0 +1,160 @@
+/**
+ * \file 240-sources.cpp
+ * \author Adam Marshall (ih8celery)
+ * \brief test options given by argv, environment variables and a config file
+ */
+
+#define WANT_TEST_EXTRAS
+#include <tap++.h>
+#include "cmdparse.h"
+#include <fstream>
+#include <cstdlib>
+#include <cstdio>
+
+using namespace TAP;
+using namespace cli;
+
+int main() {
+  plan(20);
+
+  Command cmd;
+  Diagnostics diags;
+  char * args[2];
+  const std::string path = "240-sources.conf";
+
+  cmd.option("--host=s", "host");
+  cmd.option("--port=i{1..65535}", "port");
+  cmd.option("--tags=[s]", "tags");
+  cmd.option("--set*={s:s}", "set");
+  cmd.option("--debug", "debug");
+  cmd.option("--user=s", "user");
+
+  cmd.bind_env("host", "T240_HOST");
+  cmd.bind_env("port", "T240_PORT");
+  cmd.bind_env("debug", "T240_DEBUG");
+  cmd.bind_key("host", "host");
+  cmd.bind_key("port", "port");
+  cmd.bind_key("tags", "tags");
+  cmd.bind_key("set", "set");
+  cmd.bind_key("user", "user");
+
+  TRY_NOT_OK(cmd.bind_env("bogus", "T240_BOGUS"), "undeclared option cannot be bound");
+
+  std::ofstream(path) << "# defaults\n"
+                      << "host = file.example\n"
+                      << "  port=80\n"
+                      << "\n"
+                      << "tags = a,b\n"
+                      << "set = x=1\n"
+                      << "set = y=2\n"
+                      << "user = first\n"
+                      << "user = second\n";
+
+  unsetenv("T240_HOST");
+  unsetenv("T240_PORT");
+  unsetenv("T240_DEBUG");
+
+  Info info = cmd.parse_sources(args, 0, path);
+  ok(info.find("host") == "file.example" && info.find_integer("port") == 80,
+      "config file read");
+  ok(info.find_all("tags")->size() == 2 && info.lookup("set", "y") == "2",
+      "lists and maps from the config file");
+  ok(info.find("user") == "second" && info.count("user") == 1, "later line replaces a scalar");
+
+  setenv("T240_HOST", "env.example", 1);
+  setenv("T240_DEBUG", "yes", 1);
+  info = cmd.parse_sources(args, 0, path);
+  ok(info.find("host") == "env.example", "environment wins over the config file");
+  ok(info.has("debug"), "true value sets a flag");
+
+  args[0] = (char*)"--host=argv.example";
+  info = cmd.parse_sources(args, 1, path);
+  ok(info.find("host") == "argv.example" && info.count("host") == 1,
+      "argv wins over the environment");
+
+  setenv("T240_DEBUG", "off", 1);
+  ok(!cmd.parse_sources(args, 0, path).has("debug"), "false value leaves a flag unset");
+
+  setenv("T240_PORT", "99999", 1);
+  cmd.parse_sources(args, 0, path, diags);
+  ok(diags.size() == 1 && diags[0].code == Error_Code::NOT_IN_RANGE && diags[0].index == -1,
+      "environment value checked");
+
+  try {
+    cmd.parse_sources(args, 0, path);
+    fail("bad environment value throws");
+  }
+  catch (parse_error& e) {
+    ok(std::string(e.what()).find("T240_PORT") != std::string::npos,
+        "bad environment value names the variable");
+  }
+
+  unsetenv("T240_PORT");
+  std::ofstream(path) << "host = h\n"
+                      << "port = x\n"
+                      << "color = red\n"
+                      << "nonsense\n";
+
+  diags.clear();
+  cmd.parse_sources(args, 0, path, diags);
+  is(diags.size(), 3, "every problem of the file found");
+  ok(diags[0].code == Error_Code::BAD_FORMAT && diags[0].offset == 16,
+      "problem reported at its byte in the file");
+  ok(diags[1].code == Error_Code::UNKNOWN_OPTION && diags[2].code == Error_Code::MISSING_EQUALS,
+      "unknown key and missing equals found");
+
+  std::remove(path.c_str());
+  ok(cmd.parse_sources(args, 0, path).find("host") == "env.example", "missing file skipped");
+
+  Command strict;
+
+  strict.option("--token=s", "token");
+  strict.required("token");
+  strict.bind_env("token", "T240_TOKEN");
+  setenv("T240_TOKEN", "secret", 1);
+  strict.parse_sources(args, 0, "", diags = Diagnostics());
+  ok(diags.empty(), "constraints see the environment");
+
+  unsetenv("T240_TOKEN");
+  strict.parse_sources(args, 0, "", diags);
+  ok(diags.size() == 1 && diags[0].code == Error_Code::MISSING_REQUIRED,
+      "constraints checked after every source");
+
+  Command quiet;
+
+  quiet.option("--verbose", "verbose");
+  quiet.option("--quiet", "quiet");
+  quiet.conflicts("verbose", { "quiet" });
+  quiet.bind_env("verbose", "T240_VERBOSE");
+  quiet.bind_key("verbose", "verbose");
+  setenv("T240_VERBOSE", "0", 1);
+  args[0] = (char*)"--quiet";
+  quiet.parse_sources(args, 1, "", diags = Diagnostics());
+  ok(diags.empty(), "false flag in the environment conflicts with nothing");
+
+  unsetenv("T240_VERBOSE");
+  std::ofstream(path) << "verbose = off\n";
+  quiet.parse_sources(args, 1, path, diags);
+  ok(diags.empty(), "false flag in the config file conflicts with nothing");
+
+  Command loud;
+
+  loud.option("--verbose", "verbose");
+  loud.required("verbose");
+  loud.bind_env("verbose", "T240_VERBOSE");
+  loud.bind_key("verbose", "verbose");
+  loud.parse_sources(args, 0, path, diags);
+  ok(diags.size() == 1 && diags[0].code == Error_Code::MISSING_REQUIRED,
+      "false flag in the config file does not meet required");
+
+  std::remove(path.c_str());
+  setenv("T240_VERBOSE", "false", 1);
+  loud.parse_sources(args, 0, "", diags = Diagnostics());
+  ok(diags.size() == 1 && diags[0].code == Error_Code::MISSING_REQUIRED,
+      "false flag in the environment does not meet required");
+  unsetenv("T240_VERBOSE");
+
+  done_testing();
+
+  return exit_status();
+}
@@ -0,0 +1,110 @@
+/**
+ * \file 250-live-command.cpp
+ * \author Adam Marshall (ih8celery)
+ * \brief test redeclaring options while other threads parse
+ */
+
+#define WANT_TEST_EXTRAS
+#include <tap++.h>
+#include "live_command.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace TAP;
+using namespace cli;
+
+int main() {
+  plan(7);
+
+  Command base;
+
+  base.option("--base", "base");
+
+  Live_Command live(base);
+  auto first = live.snapshot();
+
+  live.update([](Command& cmd) {
+    cmd.option("--extra", "extra");
+    cmd.option("--gen=i", "gen");
+  });
+
+  char * args[2] = { (char*)"--extra", nullptr };
+  ok(live.parse(args, 1).has("extra"), "update published");
+  ok(first->suggest("--extra").empty(), "pinned snapshot unchanged");
+
+  try {
+    live.update([](Command& cmd) {
+      cmd.option("--half", "half");
+      cmd.option("--base", "again");
+    });
+    fail("failed update throws");
+  }
+  catch (option_language_error& e) {
+    pass("failed update throws");
+  }
+
+  ok(live.snapshot()->suggest("--half").empty(), "failed update not published");
+
+  Command outer;
+  auto run = outer.command("run");
+  Command copy = outer.clone();
+
+  run->option("--late");
+  ok(copy.generation() != outer.generation(), "clone does not share subcommands");
+
+  // readers parse without pause while a writer redeclares the options
+  std::atomic<bool> stop(false);
+  std::atomic<int> failures(0), parses(0);
+  std::vector<std::thread> readers;
+
+  for (int r = 0; r < 4; ++r) {
+    readers.emplace_back([&] {
+      while (!stop.load()) {
+        auto snap = live.snapshot();
+        char * words[2] = { (char*)"--base", (char*)"--gen=1" };
+        Diagnostics diags;
+        Info info = snap->parse(words, 2, diags);
+
+        // every version declares both; a torn one would lack either
+        if (!info.has("base") || !info.has("gen") || !diags.empty()) {
+          ++failures;
+        }
+
+        ++parses;
+      }
+    });
+  }
+
+  for (int i = 0; i < 500; ++i) {
+    live.update([i](Command& cmd) {
+      cmd.clear();
+      cmd.option("--base", "base");
+      cmd.option("--gen=i", "gen");
+      cmd.option("--opt" + std::to_string(i), "opt" + std::to_string(i));
+    });
+
+    if (i % 50 == 0) {
+      std::this_thread::yield();
+    }
+  }
+
+  while (parses.load() < 1000) {
+    std::this_thread::yield();
+  }
+
+  stop = true;
+
+  for (auto& reader : readers) {
+    reader.join();
+  }
+
+  is(failures.load(), 0, "every parse saw a whole version");
+
+  char * last[1] = { (char*)"--opt499" };
+  ok(live.parse(last, 1).has("opt499"), "last update wins");
+
+  done_testing();
+
+  return exit_status();
+}
@@ -0,0 +1,14 @@
+/**
+ * \file 260-registry-flags.cpp
+ * \author Adam Marshall (ih8celery)
+ * \brief options registered by a second translation unit
+ */
+
+#include "registry.h"
+
+#define FLAG(n) CMDPARSE_DEFINE_OPTION(flag_##n, "--flag-" #n, "flag-" #n)
+
+FLAG(0); FLAG(1); FLAG(2); FLAG(3); FLAG(4); FLAG(5); FLAG(6); FLAG(7); FLAG(8); FLAG(9);
+FLAG(99);
+
+extern const int flag_count = 11;
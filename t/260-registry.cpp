@@ -0,0 +1,51 @@
+/**
+ * \file 260-registry.cpp
+ * \author Adam Marshall (ih8celery)
+ * \brief test options registered by several translation units
+ */
+
+#define WANT_TEST_EXTRAS
+#include <tap++.h>
+#include "cmdparse.h"
+#include "registry.h"
+
+using namespace TAP;
+using namespace cli;
+
+CMDPARSE_DEFINE_OPTION(verbose, "-v|--verbose", "verbose");
+CMDPARSE_DEFINE_OPTION(level, "--level=i{0..9}", "level");
+
+// defined in 260-registry-flags.cpp
+extern const int flag_count;
+
+int main() {
+  plan(6);
+
+  Command cmd;
+  std::size_t declared = cmd.declare_registered();
+
+  is(declared, 2 + flag_count, "every registration declared");
+  ok(cmd.handle_has_name("--verbose", "verbose"), "option of this unit declared");
+  ok(cmd.handle_has_name("--flag-0", "flag-0"), "option of another unit declared");
+
+  // the order of the units follows their static initialization, which is unspecified
+  int verbose = -1, level = -1;
+
+  for (int id = 0; id < (int)declared; ++id) {
+    if (cmd.option_name(id) == "verbose") verbose = id;
+    if (cmd.option_name(id) == "level") level = id;
+  }
+
+  ok(verbose >= 0 && verbose + 1 == level, "order within a unit kept");
+
+  char * args[3] = { (char*)"-v", (char*)"--level=3", (char*)"--flag-99" };
+  Info info = cmd.parse(args, 3);
+  ok(info.has("verbose") && info.find_integer("level") == 3 && info.has("flag-99"),
+      "registered options parsed");
+
+  TRY_NOT_OK(cmd.declare_registered(), "declaring twice repeats handles");
+
+  done_testing();
+
+  return exit_status();
+}
@@ -0,0 +1,62 @@
+/**
+ * \file 270-bulk-options.cpp
+ * \author Adam Marshall (ih8celery)
+ * \brief test declaring a table of options at once
+ */
+
+#define WANT_TEST_EXTRAS
+#include <tap++.h>
+#include "cmdparse.h"
+
+using namespace TAP;
+using namespace cli;
+
+int main() {
+  plan(9);
+
+  Command cmd;
+
+  is(cmd.options({ { "-v|--verbose", "verbose" },
+                   { "--level=i{0..9}", "" },
+                   { "--color!", "" } }), 3, "table declared");
+  ok(cmd.handle_has_name("--level", "level") && cmd.handle_has_name("--no-color", "color"),
+      "names deduced and negations added");
+  is(cmd.option_name(1), "level", "ids in table order");
+
+  char * args[2] = { (char*)"--verb", (char*)"-v" };
+  cmd.configure("abbrev");
+  ok(cmd.parse(args, 1).has("verbose"), "prefix index built for the table");
+
+  is(cmd.suggest("--levl").front(), "--level", "suggestions include the table");
+
+  try {
+    cmd.options({ { "--ok", "" }, { "--bad=x", "" }, { "--ok", "" }, { "-v", "" } });
+    fail("bad table throws");
+  }
+  catch (option_language_error& e) {
+    std::string msg = e.what();
+
+    ok(msg.find("3 of 4") != std::string::npos, "every bad spec counted");
+    ok(msg.find("spec 1") != std::string::npos && msg.find("spec 2") != std::string::npos
+        && msg.find("spec 3") != std::string::npos, "every bad spec listed");
+  }
+
+  ok(!cmd.handle_has_name("--ok", "ok"), "bad table declares nothing");
+
+  std::vector<Option_Spec> many;
+
+  for (int i = 0; i < 1000; ++i) {
+    many.push_back(Option_Spec{ "--opt" + std::to_string(i), "" });
+  }
+
+  Command big;
+  big.options(many);
+  args[0] = (char*)"--opt999";
+  args[1] = (char*)"--opt0";
+  Info info = big.parse(args, 2);
+  ok(info.has("opt999") && info.has("opt0"), "large table parsed");
+
+  done_testing();
+
+  return exit_status();
+}
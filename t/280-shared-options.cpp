@@ -0,0 +1,108 @@
+/**
+ * \file 280-shared-options.cpp
+ * \author Adam Marshall (ih8celery)
+ * \brief test Commands made from a shared base of options
+ */
+
+#define WANT_TEST_EXTRAS
+#include <tap++.h>
+#include "cmdparse.h"
+
+using namespace TAP;
+using namespace cli;
+
+int main() {
+  plan(17);
+
+  auto common = std::make_shared<Command>();
+
+  common->option("-v|--verbose", "verbose");
+  common->option("--level=i{0..9}", "level");
+  common->option("--color!", "color");
+  common->option("-I=|s", "include");
+  common->configure("abbrev");
+
+  std::shared_ptr<Command> sub = common->command("sub");
+  std::shared_ptr<const Command> base = common;
+  Command tenant(base);
+  Command other(base);
+
+  tenant.option("--tenant=s", "tenant");
+  tenant.option("--level=s", "level");
+
+  char * args[4] = { (char*)"--verbose", (char*)"--tenant=a", (char*)"--level=high",
+                     (char*)"-Iinc" };
+  Info info = tenant.parse(args, 4);
+
+  ok(info.has("verbose") && info.has("tenant") && info.has("include"),
+      "options of base and overlay both parsed");
+  is(*info.find("level"), "high", "overlay handle hides the base handle");
+  is(tenant.option_name(4), "tenant", "overlay ids follow those of base");
+  ok(tenant.handle_has_name("--level", "level") && tenant.handle_has_name("--no-color", "color"),
+      "handles of base found through the overlay");
+
+  char * abbrev[1] = { (char*)"--tena=b" };
+  ok(tenant.parse(abbrev, 1).has("tenant"), "abbreviation searches every layer");
+
+  char * mine[1] = { (char*)"--tenant=c" };
+  try {
+    other.parse(mine, 1);
+    fail("handles of one overlay unknown to another");
+  }
+  catch (parse_error& e) {
+    pass("handles of one overlay unknown to another");
+  }
+
+  is(common->option_name(3), "include", "base unchanged by its overlays");
+  is(tenant.suggest("--tenent").front(), "--tenant", "suggestions from the overlay");
+  is(tenant.suggest("--colr").front(), "--color", "suggestions from the base");
+
+  const char * line[1] = { "--c" };
+  std::vector<std::string> words = tenant.complete(line, 1, 0);
+  ok(words.size() == 1 && words[0] == "--color", "completion over every layer");
+
+  Diagnostics diags;
+  char * quiet[1] = { (char*)"--tenant=d" };
+
+  tenant.required("verbose");
+  tenant.parse(quiet, 1, diags);
+  ok(diags.size() == 1 && diags[0].code == Error_Code::MISSING_REQUIRED,
+      "constraints name options of the base");
+
+  Memory_Usage mem = tenant.memory_usage();
+  Memory_Usage own = common->memory_usage();
+
+  ok(mem.shared == own.own && own.shared == 0, "base counted as shared");
+  ok(other.memory_usage().own < own.own && mem.own < own.own,
+      "overlays hold less than the base");
+
+  try {
+    common->option("--late", "late");
+    fail("base refuses options once shared");
+  }
+  catch (command_error& e) {
+    pass("base refuses options once shared");
+  }
+
+  try {
+    common->configure("ignore_case");
+    fail("base refuses configuration once shared");
+  }
+  catch (command_error& e) {
+    pass("base refuses configuration once shared");
+  }
+
+  Command copy = common->clone();
+
+  copy.option("--late", "late");
+  ok(copy.handle_has_name("--late", "late"), "clone of a shared base may change");
+
+  std::uint64_t stamp = tenant.generation();
+
+  sub->option("--deep", "deep");
+  ok(tenant.generation() != stamp, "generation follows the base");
+
+  done_testing();
+
+  return exit_status();
+}
@@ -0,0 +1,60 @@
+/**
+ * \file 290-value-pool.cpp
+ * \author Adam Marshall (ih8celery)
+ * \brief test interning the elements of string lists
+ */
+
+#define WANT_TEST_EXTRAS
+#include <tap++.h>
+#include "cmdparse.h"
+#include <algorithm>
+
+using namespace TAP;
+using namespace cli;
+
+int main() {
+  plan(11);
+
+  Value_Pool pool;
+
+  is(pool.intern("prod"), 0u, "first value gets id 0");
+  ok(pool.intern("dev") == 1 && pool.intern("prod") == 0, "equal values share an id");
+  ok(!pool.find("test") && *pool.find("dev") == 1 && pool.size() == 2, "find does not insert");
+
+  Command cmd;
+
+  cmd.option("--tag*=[s]", "tag");
+  cmd.option("--name=s", "name");
+
+  char * args[4] = { (char*)"--tag=prod,dev", (char*)"--tag=prod", (char*)"--name=prod",
+                     (char*)"--tag=prod,prod" };
+  Info info;
+
+  info.intern_values();
+  cmd.parse(args, 4, &info);
+
+  const std::vector<std::uint32_t> * ids = info.find_ids("tag");
+
+  ok(ids != nullptr && ids->size() == 5, "every element kept as an id");
+  is(info.values().size(), 2, "each distinct element stored once");
+  ok((*ids)[0] == (*ids)[2] && (*ids)[0] != (*ids)[1], "equal elements have equal ids");
+  is(info.values().value((*ids)[1]), "dev", "id leads back to the element");
+  ok(info.count("tag") == 5 && info.find_all("tag")->at(4) == "prod" && *info.find("tag") == "prod",
+      "interned list read as before");
+  ok(info.find_ids("name") == nullptr && *info.find("name") == "prod", "scalars not interned");
+
+  std::string bytes = info.serialize();
+  Info copy         = Info::deserialize(bytes.data(), bytes.size());
+  auto all          = *copy.find_all("tag");
+  ok(all.size() == 5 && std::count(all.cbegin(), all.cend(), "prod") == 4,
+      "interned list serialized");
+
+  Info plain;
+  char * again[1] = { (char*)"--tag=a,b" };
+  cmd.parse(again, 1, &plain);
+  ok(plain.find_ids("tag") == nullptr && plain.count("tag") == 2, "interning is opt-in");
+
+  done_testing();
+
+  return exit_status();
+}
@@ -0,0 +1,356 @@
+/**
+ * \file 300-probes.cpp
+ * \author Adam Marshall (ih8celery)
+ * \brief test the static tracepoints of the parser
+ *
+ * the probe notes are read from the library's ELF file, as perf and
+ * bpftrace do, and each probe's nop is replaced by a breakpoint whose
+ * SIGTRAP handler records the probe and decodes its arguments.
+ */
+
+#define WANT_TEST_EXTRAS
+#include <tap++.h>
+#include "cmdparse.h"
+
+#include <elf.h>
+#include <link.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace TAP;
+using namespace cli;
+
+namespace {
+  struct Probe {
+    std::string name;
+    std::string args;
+    std::uintptr_t pc;
+    std::uintptr_t semaphore;
+  };
+
+  // where the library was loaded, and from which file
+  struct Library {
+    std::string path;
+    std::uintptr_t bias = 0;
+  };
+
+  int find_library(dl_phdr_info * info, std::size_t, void * data) {
+    Library * lib = static_cast<Library *>(data);
+
+    // linked statically, the library is part of the program, which comes first
+    if (lib->path.empty() && info->dlpi_name != nullptr && info->dlpi_name[0] == '\0') {
+      lib->path = "/proc/self/exe";
+      lib->bias = info->dlpi_addr;
+      return 0;
+    }
+
+    if (info->dlpi_name != nullptr && std::strstr(info->dlpi_name, "libcmdparse") != nullptr) {
+      lib->path = info->dlpi_name;
+      lib->bias = info->dlpi_addr;
+      return 1;
+    }
+
+    return 0;
+  }
+
+  // the probes described in .note.stapsdt, at their addresses in memory
+  std::vector<Probe> read_probes(const Library& lib) {
+    std::ifstream file(lib.path, std::ios::binary);
+    std::string image((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    std::vector<Probe> probes;
+
+    if (image.size() < sizeof(Elf64_Ehdr)) {
+      return probes;
+    }
+
+    auto header   = reinterpret_cast<const Elf64_Ehdr *>(image.data());
+    auto sections = reinterpret_cast<const Elf64_Shdr *>(image.data() + header->e_shoff);
+    const char * section_names = image.data() + sections[header->e_shstrndx].sh_offset;
+    const Elf64_Shdr * notes = nullptr;
+    std::uintptr_t base      = 0;
+
+    for (int i = 0; i < header->e_shnum; ++i) {
+      std::string name = section_names + sections[i].sh_name;
+
+      if (name == ".note.stapsdt") {
+        notes = &sections[i];
+      }
+      else if (name == ".stapsdt.base") {
+        base = sections[i].sh_addr;
+      }
+    }
+
+    if (notes == nullptr) {
+      return probes;
+    }
+
+    auto align = [](std::size_t n) { return (n + 3) & ~std::size_t(3); };
+
+    for (std::size_t at = notes->sh_offset; at < notes->sh_offset + notes->sh_size;) {
+      auto note        = reinterpret_cast<const Elf64_Nhdr *>(image.data() + at);
+      const char * own = image.data() + at + sizeof(Elf64_Nhdr);
+      const char * d   = own + align(note->n_namesz);
+
+      if (note->n_type == 3 && std::strcmp(own, "stapsdt") == 0) {
+        std::uint64_t words[3];
+        std::memcpy(words, d, sizeof(words));
+
+        const char * provider = d + sizeof(words);
+        const char * name     = provider + std::strlen(provider) + 1;
+        const char * args     = name + std::strlen(name) + 1;
+
+        // the library may have been moved since the note was written
+        probes.push_back(Probe{ name, args, lib.bias + words[0] + (base - words[1]),
+                                lib.bias + words[2] });
+      }
+
+      at = (d - image.data()) + align(note->n_descsz);
+    }
+
+    return probes;
+  }
+
+#if defined(__x86_64__)
+  // an argument as the note gives it: register, constant or memory
+  struct Operand {
+    enum { REGISTER, CONSTANT, MEMORY } kind;
+    int reg;
+    long value;
+  };
+
+  struct Event {
+    std::size_t probe;
+    std::vector<long> args;
+  };
+
+  std::vector<Probe> armed;
+  std::vector<std::vector<Operand>> operands;
+  std::vector<Event> events;
+
+  int register_index(const std::string& name) {
+    static const std::map<std::string, int> regs = {
+      { "rax", REG_RAX }, { "rbx", REG_RBX }, { "rcx", REG_RCX }, { "rdx", REG_RDX },
+      { "rsi", REG_RSI }, { "rdi", REG_RDI }, { "rbp", REG_RBP }, { "rsp", REG_RSP },
+      { "r8", REG_R8 },   { "r9", REG_R9 },   { "r10", REG_R10 }, { "r11", REG_R11 },
+      { "r12", REG_R12 }, { "r13", REG_R13 }, { "r14", REG_R14 }, { "r15", REG_R15 }
+    };
+    auto iter = regs.find(name);
+
+    return (iter == regs.cend()) ? -1 : iter->second;
+  }
+
+  // "8@%rax", "8@$5" or "8@-24(%rbp)"; reg is -1 if not understood
+  std::vector<Operand> decode(const std::string& args) {
+    std::vector<Operand> result;
+    std::size_t begin = 0;
+
+    while (begin < args.size()) {
+      std::size_t end  = args.find(' ', begin);
+      std::string spec = args.substr(begin, end - begin);
+      std::string op   = spec.substr(spec.find('@') + 1);
+      Operand operand{ Operand::REGISTER, -1, 0 };
+
+      if (op[0] == '%') {
+        operand.reg = register_index(op.substr(1));
+      }
+      else if (op[0] == '$') {
+        operand = Operand{ Operand::CONSTANT, 0, std::stol(op.substr(1)) };
+      }
+      else if (op.find("(%") != std::string::npos) {
+        std::size_t paren = op.find("(%");
+
+        operand = Operand{ Operand::MEMORY,
+                           register_index(op.substr(paren + 2, op.size() - paren - 3)),
+                           paren == 0 ? 0 : std::stol(op.substr(0, paren)) };
+      }
+
+      result.push_back(operand);
+      begin = (end == std::string::npos) ? args.size() : end + 1;
+    }
+
+    return result;
+  }
+
+  // the nop was replaced by int3, so the probe is one byte before rip
+  void on_trap(int, siginfo_t *, void * context) {
+    greg_t * regs     = static_cast<ucontext_t *>(context)->uc_mcontext.gregs;
+    std::uintptr_t at = regs[REG_RIP] - 1;
+
+    for (std::size_t i = 0; i < armed.size(); ++i) {
+      if (armed[i].pc != at) {
+        continue;
+      }
+
+      Event event{ i, {} };
+
+      for (const Operand& op : operands[i]) {
+        switch (op.kind) {
+        case Operand::REGISTER:
+          event.args.push_back(op.reg < 0 ? 0 : regs[op.reg]);
+          break;
+        case Operand::CONSTANT:
+          event.args.push_back(op.value);
+          break;
+        case Operand::MEMORY:
+          event.args.push_back(*reinterpret_cast<long *>(regs[op.reg] + op.value));
+          break;
+        }
+      }
+
+      events.push_back(event);
+    }
+  }
+
+  void patch(std::uintptr_t pc, unsigned char byte) {
+    long page = sysconf(_SC_PAGESIZE);
+    auto first = reinterpret_cast<void *>(pc & ~(page - 1));
+
+    mprotect(first, 2 * page, PROT_READ | PROT_WRITE | PROT_EXEC);
+    *reinterpret_cast<volatile unsigned char *>(pc) = byte;
+    mprotect(first, 2 * page, PROT_READ | PROT_EXEC);
+  }
+
+  // the arguments of every event of a probe, in order
+  std::vector<std::vector<long>> fired(const std::string& name) {
+    std::vector<std::vector<long>> result;
+
+    for (const Event& event : events) {
+      if (armed[event.probe].name == name) {
+        result.push_back(event.args);
+      }
+    }
+
+    return result;
+  }
+#endif
+}
+
+int main() {
+#if !defined(__x86_64__)
+  plan(1);
+  pass("probes are only checked on x86-64");
+#else
+  plan(14);
+
+  Command cmd;
+  Library lib;
+
+  cmd.option("-v", "verbose");
+  cmd.option("--nums=[i]", "nums");
+
+  dl_iterate_phdr(find_library, &lib);
+  armed = read_probes(lib);
+
+  const std::map<std::string, std::size_t> expected = {
+    { "parse__start", 2 }, { "parse__done", 3 }, { "option__lookup", 2 },
+    { "command__dispatch", 2 }, { "list__check", 3 }, { "error", 3 }
+  };
+  std::map<std::string, std::size_t> found;
+  bool nops = !armed.empty(), shaped = true;
+
+  for (const Probe& probe : armed) {
+    operands.push_back(decode(probe.args));
+    found[probe.name] = operands.back().size();
+    nops &= (*reinterpret_cast<const unsigned char *>(probe.pc) == 0x90);
+
+    for (const Operand& op : operands.back()) {
+      shaped &= (op.kind == Operand::CONSTANT || op.reg >= 0);
+    }
+  }
+
+  ok(found == expected, "a note for every probe, with its arguments");
+  ok(nops, "each probe is a nop");
+  ok(shaped, "every argument is a register, constant or memory");
+
+  struct sigaction action;
+  std::memset(&action, 0, sizeof(action));
+  action.sa_sigaction = on_trap;
+  action.sa_flags     = SA_SIGINFO;
+  sigaction(SIGTRAP, &action, nullptr);
+
+  events.reserve(64);
+
+  for (const Probe& probe : armed) {
+    patch(probe.pc, 0xCC);
+
+    // a tracer counts itself in, so the duration is measured
+    if (probe.name == "parse__done") {
+      ++*reinterpret_cast<volatile unsigned short *>(probe.semaphore);
+    }
+  }
+
+  Diagnostics diags;
+  char * args[3] = { (char*)"-v", (char*)"--nums=1,x,3", (char*)"--bogus" };
+
+  cmd.parse(args, 3, diags);
+
+  auto start = fired("parse__start");
+  ok(start.size() == 1 && start[0][0] == 3, "parse__start gives argc");
+
+  auto lookups = fired("option__lookup");
+  ok(lookups.size() == 3 && lookups[0] == std::vector<long>{ 0, 0 }
+      && lookups[1] == std::vector<long>{ 1, 1 } && lookups[2] == std::vector<long>{ 2, -1 },
+      "option__lookup gives index and id, -1 on a miss");
+
+  auto lists = fired("list__check");
+  ok(lists.size() == 1 && lists[0] == std::vector<long>{ 1, 2, 1 },
+      "list__check counts kept and rejected elements");
+
+  auto errors = fired("error");
+  ok(errors.size() == 2 && errors[0][0] == (long)Error_Code::BAD_FORMAT
+      && errors[0][2] == 1, "error gives code and option of a bad element");
+  ok(errors.size() == 2 && errors[1][0] == (long)Error_Code::UNKNOWN_OPTION
+      && errors[1][1] == 2 && errors[1][2] == -1, "error gives index of an unknown option");
+
+  auto done = fired("parse__done");
+  ok(done.size() == 1 && done[0][0] == 3 && done[0][1] == 2, "parse__done counts problems");
+  ok(done.size() == 1 && done[0][2] > 0, "duration measured while a tracer is attached");
+
+  Command git;
+  auto remote = git.command("remote");
+  remote->option("--fetch");
+
+  char * nested[2] = { (char*)"remote", (char*)"--fetch" };
+  git.parse(nested, 2);
+
+  auto dispatch = fired("command__dispatch");
+  ok(dispatch.size() == 1 && dispatch[0] == std::vector<long>{ 0, 2 },
+      "command__dispatch gives the subcommand and its words");
+  is(fired("parse__start").size(), 2, "a subcommand is not a parse of its own");
+
+  Command merged;
+  merged.configure("merged_opt");
+  merged.option("v", "verbose");
+  merged.option("q", "quiet");
+
+  char * letters[1] = { (char*)"-vqx" };
+  std::size_t seen = fired("option__lookup").size();
+  merged.parse(letters, 1, diags);
+
+  lookups = fired("option__lookup");
+  lookups.erase(lookups.begin(), lookups.begin() + seen);
+  ok(lookups.size() == 3 && lookups[0] == std::vector<long>{ 0, 0 }
+      && lookups[1] == std::vector<long>{ 0, 1 } && lookups[2] == std::vector<long>{ 0, -1 },
+      "option__lookup fires for each letter of a merged word");
+
+  for (const Probe& probe : armed) {
+    patch(probe.pc, 0x90);
+  }
+
+  std::size_t before = events.size();
+  char * again[1] = { (char*)"-v" };
+  cmd.parse(again, 1);
+  is(events.size(), before, "nothing fires once the breakpoints are gone");
+#endif
+
+  done_testing();
+
+  return exit_status();
+}
@@ -0,0 +1,141 @@
+/**
+ * \file 310-budget.cpp
+ * \author Adam Marshall (ih8celery)
+ * \brief test the allocations and time spent by a parse
+ *
+ * the budgets hold with some room over what the parser needs now, so
+ * they fail on a regression, not on a change of compiler or library.
+ */
+
+#define WANT_TEST_EXTRAS
+#include <tap++.h>
+#include "cmdparse.h"
+#include "budget.h"
+
+#include <string>
+#include <vector>
+
+using namespace TAP;
+using namespace cli;
+
+namespace {
+  // pointers to words, made again before each parse blanks them
+  std::vector<char *> argv_of(std::vector<std::string>& words) {
+    std::vector<char *> argv;
+
+    for (std::string& word : words) {
+      argv.push_back(&word[0]);
+    }
+
+    return argv;
+  }
+}
+
+int main() {
+  plan(7);
+
+  budget::Region region;
+  int * probe = new int(0);
+  budget::Usage usage = region.usage();
+
+  ok(usage.allocations == 1 && usage.bytes == sizeof(int), "operator new counted");
+  delete probe;
+
+  Command flags;
+  std::vector<std::string> words;
+
+  for (char ch = 'a'; ch < 'k'; ++ch) {
+    flags.option(std::string("-") + ch + "*");
+  }
+
+  for (int i = 0; i < 1000; ++i) {
+    words.push_back(std::string("-") + char('a' + i % 10));
+  }
+
+  Info reused;
+  std::vector<char *> argv = argv_of(words);
+  flags.permute(argv.data(), argv.size(), reused);
+
+  argv = argv_of(words);
+  region.reset();
+  flags.permute(argv.data(), argv.size(), reused);
+  usage = region.usage();
+
+  ok(usage.allocations <= 1100, "1000 flags into a reused Info: at most 1100 allocations");
+
+  argv = argv_of(words);
+  region.reset();
+  Info fresh = flags.parse(argv.data(), argv.size());
+
+  usage = region.usage();
+  ok(usage.allocations <= 1100, "the Info parse returns is not copied");
+
+  region.reset();
+  std::size_t found = 0;
+
+  for (int i = 0; i < 1000; ++i) {
+    found += fresh.has("a");
+  }
+
+  // read before ok(), whose message is itself allocated
+  usage = region.usage();
+  ok(found == 1000 && usage.allocations == 0, "has() allocates nothing");
+
+  Command tags;
+  std::string list("--tag=");
+
+  tags.option("--tag*=[s]", "tag");
+
+  for (int i = 0; i < 1000; ++i) {
+    list += (i % 2) ? "production-east," : "production-west,";
+  }
+
+  char * one[1] = { &list[0] };
+  Info interned;
+
+  interned.intern_values();
+  region.reset();
+  tags.parse(one, 1, &interned);
+  usage = region.usage();
+
+  ok(interned.count("tag") == 1000 && usage.allocations <= 100,
+      "1000 interned elements of 2 values: at most 100 allocations");
+
+  Command mixed;
+  std::vector<std::string> line;
+
+  mixed.option("-v*", "verbose");
+  mixed.option("--tags*=[s]", "tags");
+  mixed.option("--level*=[i]", "level");
+
+  for (int i = 0; i < 25; ++i) {
+    line.push_back("-v");
+    line.push_back("--tags=a,b");
+    line.push_back("--level=" + std::to_string(i));
+    line.push_back("file");
+  }
+
+  std::uint64_t best = ~std::uint64_t(0);
+
+  for (int run = 0; run < 10; ++run) {
+    argv = argv_of(line);
+
+    std::uint64_t start = budget::cycles();
+    Info info           = mixed.parse(argv.data(), argv.size());
+    std::uint64_t spent = budget::cycles() - start;
+
+    best = std::min(best, spent);
+  }
+
+  ok(best < 50000000, "100 words parsed in under 50M cycles");
+
+  region.reset();
+  argv = argv_of(line);
+  mixed.parse(argv.data(), argv.size());
+  usage = region.usage();
+  ok(usage.allocations <= 400, "100 words: at most 400 allocations");
+
+  done_testing();
+
+  return exit_status();
+}
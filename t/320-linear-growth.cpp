@@ -0,0 +1,148 @@
+/**
+ * \file 320-linear-growth.cpp
+ * \author Adam Marshall (ih8celery)
+ * \brief test that parse time grows linearly with hostile input
+ *
+ * each input is parsed at a size n and at 8n. a linear parser takes
+ * about 8 times as long on the larger; one quadratic in the size takes
+ * 64. the test fails past 24, which leaves room for caches and noise.
+ *
+ * glibc serves large blocks with mmap and moves that threshold as
+ * blocks are freed, so one size could pay for fresh pages while the
+ * other reuses the heap. both thresholds are pinned to keep every
+ * size of the multi-megabyte cases on the heap.
+ */
+
+#define WANT_TEST_EXTRAS
+#include <tap++.h>
+#include "cmdparse.h"
+#include "budget.h"
+
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <vector>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+using namespace TAP;
+using namespace cli;
+
+namespace {
+  const int growth    = 8;
+  const double bound  = 24.0;
+
+  // the least time of several parses of the words make(n) gives
+  std::uint64_t best_time(const Command& cmd,
+                          const std::function<std::vector<std::string>(int)>& make, int n) {
+    std::vector<std::string> words = make(n);
+    std::uint64_t best             = ~std::uint64_t(0);
+
+    for (int run = 0; run < 5; ++run) {
+      std::vector<std::string> copy = words;
+      std::vector<char *> argv;
+      Diagnostics diags;
+
+      for (std::string& word : copy) {
+        argv.push_back(&word[0]);
+      }
+
+      std::uint64_t start = budget::cycles();
+      cmd.parse(argv.data(), argv.size(), diags);
+      best = std::min(best, budget::cycles() - start);
+    }
+
+    return best;
+  }
+
+  // how many times longer the parse of size growth * n takes than that of n
+  double ratio(const Command& cmd, const std::function<std::vector<std::string>(int)>& make,
+               int n) {
+    double small = std::max<std::uint64_t>(best_time(cmd, make, n), 1);
+    double large = best_time(cmd, make, growth * n);
+
+    note("n = " + std::to_string(n) + ": " + std::to_string(large / small) + " times as long");
+
+    return large / small;
+  }
+}
+
+int main() {
+#ifdef __GLIBC__
+  mallopt(M_MMAP_THRESHOLD, 1 << 30);
+  mallopt(M_TRIM_THRESHOLD, 1 << 30);
+#endif
+
+  plan(8);
+
+  Command repeats;
+  repeats.option("-v*", "verbose");
+  repeats.option("--tag*=[s]", "tag");
+
+  ok(ratio(repeats, [](int n) {
+        std::vector<std::string> words;
+
+        for (int i = 0; i < n; ++i) {
+          words.push_back((i % 2) ? "-v" : "--tag=x");
+        }
+
+        return words;
+      }, 2000) < bound, "repeats of a * option");
+
+  Command lists;
+  lists.option("--tags=[s]", "tags");
+  lists.option("--ids=[i]", "ids");
+
+  ok(ratio(lists, [](int n) {
+        return std::vector<std::string>{ "--tags=" + std::string(n, ',') };
+      }, 20000) < bound, "a list of empty elements");
+
+  ok(ratio(lists, [](int n) {
+        return std::vector<std::string>{ "--ids=" + std::string(n, ',') };
+      }, 20000) < bound, "an integer list of empty elements");
+
+  Command longs;
+  longs.option("--name=s", "name");
+
+  ok(ratio(longs, [](int n) {
+        return std::vector<std::string>{ "--name=" + std::string(n, 'a') };
+      }, 12000) < bound, "a long argument");
+
+  ok(ratio(longs, [](int n) {
+        return std::vector<std::string>{ "--" + std::string(n, 'a') };
+      }, 12000) < bound, "a long unknown handle");
+
+  ok(ratio(longs, [](int n) {
+        return std::vector<std::string>{ "--name=" + std::string(n, 'a') };
+      }, 1 << 20) < bound, "a multi-megabyte argument");
+
+  ok(ratio(longs, [](int n) {
+        return std::vector<std::string>{ "--" + std::string(n, 'a') };
+      }, 1 << 20) < bound, "a multi-megabyte unknown handle");
+
+  // the chain is declared once, deep enough for the larger input
+  Command root;
+  Command * last = &root;
+  std::vector<std::shared_ptr<Command>> chain;
+
+  for (int i = 0; i < growth * 200; ++i) {
+    chain.push_back(last->command("c" + std::to_string(i)));
+    last = chain.back().get();
+  }
+
+  ok(ratio(root, [](int n) {
+        std::vector<std::string> words;
+
+        for (int i = 0; i < n; ++i) {
+          words.push_back("c" + std::to_string(i));
+        }
+
+        return words;
+      }, 200) < bound, "a deep chain of subcommands");
+
+  done_testing();
+
+  return exit_status();
+}
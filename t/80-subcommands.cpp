@@ -25,14 +25,33 @@ int main() {
 
   auto info = cmd.parse(argv, 2);
 
-  plan(2);
+  plan(6);
 
   ok(info.has_command("remote"), "subcommand 'remote'");
   ok(info.has_command("add"), "subcommand 'add'");
 
+  cmd.option("--verbose");
+  cmd2->option("--force");
+
+  char ** argv2 = new char*[5];
+  argv2[0] = (char*)("remote");
+  argv2[1] = (char*)("add");
+  argv2[2] = (char*)("--force");
+  argv2[3] = (char*)("origin");
+  argv2[4] = (char*)("--verbose");
+
+  info = cmd.parse(argv2, 5);
+
+  ok(info.has("force"), "subcommand option found");
+  ok(info.has("verbose"), "options unknown to a subcommand left to its parent");
+  ok(info.rest.size() == 1, "non-options collected once");
+  ok(std::string(argv2[0]) == "remote" && std::string(argv2[2]) == "--force"
+      && std::string(argv2[4]) == "--verbose", "parse leaves argv as given");
+
   done_testing();
 
   delete [] argv;
+  delete [] argv2;
 
   return exit_status();
 }
@@ -0,0 +1,130 @@
+/**
+ * \file budget.cpp
+ * \author Adam Marshall (ih8celery)
+ * \brief count allocations and time a region of a test
+ */
+#include "budget.h"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace {
+  std::atomic<std::size_t> allocations{ 0 };
+  std::atomic<std::size_t> bytes{ 0 };
+
+  budget::Usage now() noexcept {
+    return budget::Usage{ allocations.load(std::memory_order_relaxed),
+                          bytes.load(std::memory_order_relaxed) };
+  }
+
+  void * counted(std::size_t size, std::size_t align = 0) noexcept {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    bytes.fetch_add(size, std::memory_order_relaxed);
+
+    if (size == 0) {
+      size = 1;
+    }
+
+    if (align > alignof(std::max_align_t)) {
+      void * ptr = nullptr;
+
+      return (posix_memalign(&ptr, align, size) == 0) ? ptr : nullptr;
+    }
+
+    return std::malloc(size);
+  }
+
+  void * counted_or_throw(std::size_t size, std::size_t align = 0) {
+    void * ptr = counted(size, align);
+
+    if (ptr == nullptr) {
+      throw std::bad_alloc();
+    }
+
+    return ptr;
+  }
+}
+
+namespace budget {
+  Region::Region() noexcept: start(now()) {}
+
+  Usage Region::usage() const noexcept {
+    Usage end = now();
+
+    return Usage{ end.allocations - start.allocations, end.bytes - start.bytes };
+  }
+
+  void Region::reset() noexcept {
+    start = now();
+  }
+
+  std::uint64_t cycles() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+  }
+}
+
+void * operator new(std::size_t size) {
+  return counted_or_throw(size);
+}
+
+void * operator new[](std::size_t size) {
+  return counted_or_throw(size);
+}
+
+void * operator new(std::size_t size, const std::nothrow_t&) noexcept {
+  return counted(size);
+}
+
+void * operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+  return counted(size);
+}
+
+void * operator new(std::size_t size, std::align_val_t align) {
+  return counted_or_throw(size, static_cast<std::size_t>(align));
+}
+
+void * operator new[](std::size_t size, std::align_val_t align) {
+  return counted_or_throw(size, static_cast<std::size_t>(align));
+}
+
+void operator delete(void * ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void * ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void * ptr, std::size_t) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void * ptr, std::size_t) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void * ptr, std::align_val_t) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void * ptr, std::align_val_t) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void * ptr, std::size_t, std::align_val_t) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void * ptr, std::size_t, std::align_val_t) noexcept {
+  std::free(ptr);
+}
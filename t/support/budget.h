@@ -0,0 +1,62 @@
+/**
+ * \file budget.h
+ * \author Adam Marshall (ih8celery)
+ * \brief count allocations and time a region of a test
+ *
+ * linking the budget library replaces the global operator new and
+ * operator delete of the test with versions that count every call
+ * and the bytes asked for, on every thread, before handing the work
+ * to malloc and free.
+ */
+#ifndef _MOD_CPP_COMMAND_PARSE_TEST_BUDGET
+
+#define _MOD_CPP_COMMAND_PARSE_TEST_BUDGET
+
+#include <cstddef>
+#include <cstdint>
+
+namespace budget {
+  /**
+   * \struct Usage
+   * \brief allocations made, and bytes asked for, during a region
+   */
+  struct Usage {
+    std::size_t allocations;
+    std::size_t bytes;
+  };
+
+  /**
+   * \class Region
+   * \brief counts the allocations made from construction until usage()
+   */
+  class Region {
+    public:
+      Region() noexcept;
+
+      /**
+       * \fn Usage usage() const
+       * \brief the allocations made since construction, or since reset()
+       */
+      Usage usage() const noexcept;
+
+      /**
+       * \fn void reset()
+       * \brief start counting again from zero
+       */
+      void reset() noexcept;
+
+    private:
+      Usage start;
+  };
+
+  /**
+   * \fn std::uint64_t cycles()
+   * \brief the cycle counter on x86, nanoseconds elsewhere
+   *
+   * for bounds loose enough to hold on any machine the tests run on; <br>
+   * take the least of several runs so one preemption does not count <br>
+   */
+  std::uint64_t cycles() noexcept;
+}
+
+#endif